@@ -0,0 +1,77 @@
+// Tensor file writer throughput: the text writers of tensure_core against a plain ofstream writer.
+//
+// Usage: serializer_bench [nnz (default 10000000)] [out_dir (default /tmp)]
+
+#include "tensure/random_gen.hpp"
+#include "tensure/tensor_io.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+using namespace std;
+
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// The previous writer: one ofstream << per coordinate and value
+static void ofstream_save(const tsTensorData& data, const string& filename)
+{
+    ofstream out(filename);
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        const int* coord = data.coord(i);
+        for (size_t j = 0; j < data.rank; j++)
+            out << coord[j] << " ";
+        out << data.data[i] << "\n";
+    }
+}
+
+static void report(const string& name, const string& filename, double secs)
+{
+    double mb = fs::file_size(filename) / 1e6;
+    cout << left << setw(28) << name << fixed << setprecision(3) << setw(9) << secs << " s  "
+         << setprecision(1) << setw(9) << mb << " MB  " << mb / secs << " MB/s\n";
+}
+
+int main(int argc, char* argv[])
+{
+    uint64_t nnz = (argc > 1) ? stoull(argv[1]) : 10'000'000;
+    fs::path out_dir = (argc > 2) ? argv[2] : "/tmp";
+
+    // rank-3 tensor at density 0.4 with about nnz nonzeros
+    tsTensor tensor;
+    int dim = static_cast<int>(cbrt(nnz / 0.4)) + 1;
+    tensor.shape = {dim, dim, dim};
+
+    auto start = chrono::steady_clock::now();
+    auto data = make_shared<tsTensorData>();
+    fill_random_tensor_data(tensor, *data, 0.4, 42);
+    cout << "generated " << data->size() << " nonzeros (" << dim << "^3) in " << seconds_since(start) << " s\n\n";
+
+    string legacy_file = (out_dir / "bench_ofstream.tns").string();
+    start = chrono::steady_clock::now();
+    ofstream_save(*data, legacy_file);
+    report("ofstream <<", legacy_file, seconds_since(start));
+
+    string tns_file = (out_dir / "bench_writer.tns").string();
+    start = chrono::steady_clock::now();
+    save_tensor_data(tensor.shape, *data, tns_file, "tns");
+    report("to_chars + write(2)", tns_file, seconds_since(start));
+
+    // Time the caller is blocked for when the write happens in the background
+    string bg_file = (out_dir / "bench_background.tns").string();
+    BackgroundTensorWriter writer(1);
+    start = chrono::steady_clock::now();
+    future<bool> done = writer.submit(tensor.shape, data, bg_file, "tns");
+    double blocked = seconds_since(start);
+    done.get();
+    report("background writer", bg_file, seconds_since(start));
+    cout << "  caller blocked for " << blocked * 1e3 << " ms\n";
+
+    for (const auto& f : {legacy_file, tns_file, bg_file})
+        fs::remove(f);
+    return 0;
+}
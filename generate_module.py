@@ -28,6 +28,7 @@ struct {module_backend_name}Backend : public FuzzBackend {{
 // Plugin entry points
 extern "C" FuzzBackend* create_backend();
 extern "C" void destroy_backend(FuzzBackend* backend);
+extern "C" bool backend_thread_safe();
 """
 
 TEMPLATE_SOURCE = """#include "{module_name}_wrapper/{module_name}_backend.hpp"
@@ -57,6 +58,12 @@ extern "C" void destroy_backend(FuzzBackend* backend) {{
     delete backend;
 }}
 
+// Return true only if one instance may be used from several threads at once;
+// otherwise TenSure creates one instance per worker thread.
+extern "C" bool backend_thread_safe() {{
+    return false;
+}}
+
 """
 
 def append_to_cmake(module_name: str, cmake_path: str ="CMakeLists.txt"):
@@ -73,7 +80,7 @@ def append_to_cmake(module_name: str, cmake_path: str ="CMakeLists.txt"):
             ${CMAKE_SOURCE_DIR}/src/finch_wrapper/*.cpp
         )
         add_library(finch_wrapper SHARED ${FINCH_SRC})
-        target_include_directories(finch_wrapper PUBLIC ${CMAKE_SOURCE_DIR}/include)
+        target_link_libraries(finch_wrapper PRIVATE tensure_core)
     endif()
     '''
     lines_to_add = f"""
@@ -85,7 +92,7 @@ if (BUILD_{module_name.upper()})
         ${{CMAKE_SOURCE_DIR}}/src/{module_name.lower()}_wrapper/*.cpp
     )
     add_library({module_name.lower()}_wrapper SHARED ${{{module_name.upper()}_SRC}})
-    target_include_directories({module_name}_wrapper PUBLIC ${{CMAKE_SOURCE_DIR}}/include)
+    target_link_libraries({module_name.lower()}_wrapper PRIVATE tensure_core)
 endif()
 """
 
@@ -2,22 +2,150 @@
 #include <string>
 #include <vector>
 #include "tensure/formats.hpp"
+#include "tensure/comparator.hpp"
 #include <dlfcn.h>
 #include <iostream>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include <filesystem>
 
 using namespace std;
 namespace fs = std::filesystem;
 
+// execute_kernel result for a kernel the harness could not run: it is skipped, not reported as a crash
+const int BACKEND_SKIPPED = -3;
+
 struct FuzzBackend {
     virtual ~FuzzBackend() = default;
 
     virtual bool generate_kernel(const vector<string>& mutated_kernel_file_names, const fs::path& output_dir) = 0;
 
+    /**
+     * Generate from kernels the fuzzer holds in memory. kernel_file_names[i] names kernels[i] (its
+     * stem is the kernel directory) and is where its JSON is written if the backend needs it: the
+     * default writes the files that do not exist yet and calls the file-based overload.
+     */
+    virtual bool generate_kernel(const vector<tsKernel>& kernels, const vector<string>& kernel_file_names, const fs::path& output_dir) {
+        for (size_t i = 0; i < kernels.size(); i++)
+            if (!fs::exists(kernel_file_names[i])) kernels[i].saveJson(kernel_file_names[i]);
+        return generate_kernel(kernel_file_names, output_dir);
+    }
+
+    /**
+     * Run a generated kernel. Returns 0 on success, BACKEND_SKIPPED when the backend's own harness
+     * could not run it (reading inputs, writing results, running out of memory), and any other
+     * value when the kernel itself failed, which the fuzzer reports as a crash.
+     */
     virtual int execute_kernel(const fs::path& kernelPath, const fs::path& outputDir) = 0;
 
     virtual bool compare_results(const string& refDir, const string& testDir) = 0;
+
+    /**
+     * Compare against a reference output the fuzzer has already parsed. It is loaded once per
+     * iteration and shared by the comparisons of every mutant; the default re-reads ref.path().
+     */
+    virtual bool compare_results(const ReferenceOutput& ref, const string& testDir) { return compare_results(ref.path(), testDir); }
+};
+
+// Plugin entry points.
+// Every plugin exports `create_backend` and `destroy_backend`. A plugin may also
+// export `backend_thread_safe`; returning true promises that a single instance can be
+// driven concurrently from several worker threads. Plugins without the symbol are
+// treated as not thread-safe and get one instance per worker.
+// A plugin that exports `backend_supports_schedules` returning true applies the
+// schedules of tsComputation; without it the SCHEDULE mutation operator is not used.
+using create_backend_fn = FuzzBackend* (*)();
+using destroy_backend_fn = void (*)(FuzzBackend*);
+using backend_thread_safe_fn = bool (*)();
+using backend_supports_schedules_fn = bool (*)();
+
+/**
+ * How worker threads obtain a backend instance.
+ * AUTO       - SHARED for thread-safe plugins, PER_THREAD otherwise.
+ * SHARED     - one instance used by every worker.
+ * PER_THREAD - `create_backend` is called once per worker thread.
+ * POOL       - instances are leased per job from a bounded pool.
+ */
+enum class InstancePolicy {
+    AUTO,
+    SHARED,
+    PER_THREAD,
+    POOL
 };
 
-// Utility to dynamically load/unload backend plugins
-FuzzBackend* load_backend(const std::string& so_path);
-void unload_backend(FuzzBackend* backend);
+string to_string(InstancePolicy policy);
+InstancePolicy parseInstancePolicy(const string& s);
+
+struct PluginHandle {
+    void* dl = nullptr;
+    string path;
+    create_backend_fn create_fn = nullptr;
+    destroy_backend_fn destroy_fn = nullptr;
+    bool thread_safe = false;
+    bool supports_schedules = false;
+};
+
+/**
+ * Open a backend plugin and resolve its entry points. No instance is created.
+ * @param so_path path to the backend shared library
+ * @throw runtime_error if the library or a required symbol cannot be found
+ * @return PluginHandle holding the resolved entry points
+ */
+PluginHandle load_plugin(const string& so_path);
+void unload_plugin(PluginHandle& ph);
+
+/**
+ * Hands out backend instances to worker threads according to an InstancePolicy.
+ * Owns every instance it creates and destroys them before the plugin is unloaded.
+ */
+class BackendInstances {
+public:
+    class Lease {
+    public:
+        Lease(BackendInstances* owner, FuzzBackend* inst) : owner_(owner), inst_(inst) {}
+        Lease(Lease&& other) noexcept : owner_(other.owner_), inst_(other.inst_) { other.inst_ = nullptr; }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() { if (inst_) owner_->release(inst_); }
+
+        FuzzBackend* get() const { return inst_; }
+        FuzzBackend* operator->() const { return inst_; }
+
+    private:
+        BackendInstances* owner_;
+        FuzzBackend* inst_;
+    };
+
+    /**
+     * @param plugin loaded plugin to create instances from
+     * @param policy instance policy (AUTO is resolved from the plugin's thread-safety)
+     * @param max_instances upper bound on live instances for the POOL policy
+     */
+    BackendInstances(const PluginHandle& plugin, InstancePolicy policy, size_t max_instances);
+    ~BackendInstances();
+
+    BackendInstances(const BackendInstances&) = delete;
+    BackendInstances& operator=(const BackendInstances&) = delete;
+
+    // Blocks under the POOL policy until an instance is free.
+    Lease acquire();
+
+    InstancePolicy policy() const { return policy_; }
+    size_t instance_count();
+
+private:
+    void release(FuzzBackend* inst);
+    FuzzBackend* create();
+
+    const PluginHandle& plugin_;
+    InstancePolicy policy_;
+    size_t max_instances_;
+
+    mutex mtx_;
+    condition_variable cv_;
+    vector<FuzzBackend*> all_;
+    vector<FuzzBackend*> free_;
+    unordered_map<thread::id, FuzzBackend*> per_thread_;
+};
@@ -16,8 +16,12 @@ struct FinchBackend : public FuzzBackend {
                      const fs::path &outputDir) override;
 
   bool compare_results(const string &refDir, const string &testDir) override;
+
+  bool compare_results(const ReferenceOutput &ref,
+                       const string &testDir) override;
 };
 
 // Plugin entry points
 extern "C" FuzzBackend *create_backend();
 extern "C" void destroy_backend(FuzzBackend *backend);
+extern "C" bool backend_thread_safe();
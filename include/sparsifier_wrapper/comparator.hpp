@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+#include "tensure/comparator.hpp"
+
+namespace sparsifier_wrapper
+{
+using namespace std;
+
+// Results are written in the shared .tns layout, so the core comparator is reused
+bool compare_outputs(const std::string& ref_output, const std::string& kernel_output, double tol = 1e-8);
+// Against a reference parsed once for all mutants
+bool compare_outputs(const ReferenceOutput& ref, const std::string& kernel_output, double tol = 1e-8);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "tensure/formats.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <filesystem>
+
+namespace mlir {
+class MLIRContext;
+}
+
+namespace sparsifier_wrapper {
+using namespace std;
+namespace fs = std::filesystem;
+
+// Return codes of JitExecutor::run_kernel
+enum JitStatus {
+    JIT_OK = 0,
+    JIT_PARSE_FAILED = 1,
+    JIT_LOWERING_FAILED = 2,
+    JIT_ENGINE_FAILED = 3,
+    JIT_INVOKE_FAILED = 4,
+    JIT_IO_FAILED = 5           // reading the inputs or writing the output failed, memory included
+};
+
+// Input tensor file as the level buffers of a COO tensor (0-based coordinates, file order)
+typedef struct CooBuffer {
+    vector<int64_t> positions;              // {0, nnz}
+    vector<vector<int64_t>> coordinates;    // one per mode
+    vector<double> values;                  // a scalar always has exactly one
+} CooBuffer;
+
+/**
+ * Compiles MLIR kernels with the sparsifier pipeline and runs them in-process through
+ * MLIR's ExecutionEngine. Holds an MLIRContext and a cache of parsed input tensors,
+ * so one instance must not be used from several threads at once.
+ */
+class JitExecutor {
+public:
+    JitExecutor();
+    ~JitExecutor();
+
+    /**
+     * Lower, JIT-compile and run the `@kernel` function of an MLIR module.
+     * @param mlir_source module produced by generate_mlir_module
+     * @param kernel kernel specification (input data files and shapes)
+     * @param results_file files to write the output tensor to (1-based coordinates, nonzeros only)
+     * @return JIT_OK on success, otherwise the JitStatus of the failed step
+     */
+    int run_kernel(const string& mlir_source, const tsKernel& kernel, const vector<fs::path>& results_file);
+
+    // Drop cached inputs (called when a new iteration's reference kernel is generated)
+    void clear_input_cache();
+
+private:
+    const CooBuffer& load_input(const string& data_file, const vector<int>& shape);
+
+    unique_ptr<mlir::MLIRContext> context_;
+    map<string, CooBuffer> input_cache_;
+};
+
+}
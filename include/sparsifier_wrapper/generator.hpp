@@ -0,0 +1,33 @@
+#pragma once
+
+#include "tensure/formats.hpp"
+#include "tensure/utils.hpp"
+
+#include <string>
+#include <filesystem>
+
+namespace sparsifier_wrapper {
+using namespace std;
+namespace fs = std::filesystem;
+
+/**
+ * Lower a tsKernel to an MLIR module holding a single `linalg.generic` over
+ * `sparse_tensor`-annotated operands. Each tensor's TensorFormat becomes the level types
+ * of its encoding (Dense -> dense, Sparse -> compressed).
+ *
+ * The generated `@kernel` function takes each input (in kernel.tensors order) as the level buffers
+ * of a COO tensor: positions {0, nnz}, one coordinate buffer per mode and the values. It assembles
+ * and converts them to their encodings, and returns a sparse output as COO as well: one coordinate
+ * buffer per mode, then the values. Scalars are passed and returned as dense tensors.
+ * @param kernel kernel to lower
+ * @return MLIR module source
+ */
+string generate_mlir_module(const tsKernel& kernel);
+
+/**
+ * Write the MLIR module and the kernel specification into out_dir (kernel.mlir, kernel.json).
+ * @return MLIR module source, empty on failure
+ */
+string generate_sparsifier_kernel(const tsKernel& kernel, const fs::path& out_dir);
+
+}
@@ -6,6 +6,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
@@ -16,12 +17,28 @@ namespace fs = std::filesystem;
 struct SparsifierBackend : public FuzzBackend {
     bool generate_kernel(const vector<string>& mutated_kernel_file_names, const fs::path& output_dir) override;
 
+    bool generate_kernel(const vector<tsKernel>& kernels, const vector<string>& kernel_file_names, const fs::path& output_dir) override;
+
     int execute_kernel(const fs::path& kernelPath, const fs::path& outputDir) override;
 
     bool compare_results(const string& refDir,
                          const string& testDir) override;
+
+    bool compare_results(const ReferenceOutput& ref, const string& testDir) override;
+
+private:
+    typedef struct PreparedKernel {
+        tsKernel kernel;
+        string mlir_source;
+        vector<fs::path> results_file;
+    } PreparedKernel;
+
+    // Kernels generated for the current iteration, keyed by their kernel directory
+    map<fs::path, PreparedKernel> prepared_;
+    sparsifier_wrapper::JitExecutor executor_;
 };
 
 // Plugin entry points
 extern "C" FuzzBackend* create_backend();
 extern "C" void destroy_backend(FuzzBackend* backend);
+extern "C" bool backend_thread_safe();
@@ -9,9 +9,14 @@
 #include <stdexcept>
 #include <iostream>
 
+#include "tensure/comparator.hpp"
+
 namespace taco_wrapper
 {
 using namespace std;
 
-bool compare_outputs(const std::string& ref_output, const std::string& kernel_output, double total = 1e-8);
+// Results are written in the shared .tns layout, so the core comparator is reused
+bool compare_outputs(const std::string& ref_output, const std::string& kernel_output, double tol = 1e-8);
+// Against a reference parsed once for all mutants
+bool compare_outputs(const ReferenceOutput& ref, const std::string& kernel_output, double tol = 1e-8);
 }
\ No newline at end of file
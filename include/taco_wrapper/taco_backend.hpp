@@ -16,12 +16,18 @@ namespace fs = std::filesystem;
 struct TacoBackend : public FuzzBackend {
     bool generate_kernel(const vector<string>& mutated_kernel_file_names, const fs::path& output_dir) override;
 
+    bool generate_kernel(const vector<tsKernel>& kernels, const vector<string>& kernel_file_names, const fs::path& output_dir) override;
+
     int execute_kernel(const fs::path& kernelPath, const fs::path& outputDir) override;
 
     bool compare_results(const string& refDir,
                          const string& testDir) override;
+
+    bool compare_results(const ReferenceOutput& ref, const string& testDir) override;
 };
 
 // Plugin entry points
 extern "C" FuzzBackend* create_backend();
 extern "C" void destroy_backend(FuzzBackend* backend);
+extern "C" bool backend_thread_safe();
+extern "C" bool backend_supports_schedules();
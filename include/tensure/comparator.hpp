@@ -0,0 +1,193 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+
+using namespace std;
+
+/**
+ * Output tensor comparison.
+ *
+ * Files are memory-mapped and parsed in place with from_chars (.tns, .ttx, .mtx) or read directly
+ * from the binary layout (.tsb). Zero values are skipped and coordinates are compared as stored.
+ * The reference is loaded once into flat arrays and indexed by a 64-bit key per nonzero: the
+ * coordinates linearized over the reference's bounding box, or a hash of them when that box does
+ * not fit in 64 bits. The other file is then streamed against the index and the comparison stops
+ * at the first missing coordinate, value mismatch, or when it cannot have enough entries.
+ *
+ * Dense or near-dense references (and small ones) are instead scattered into a flat array over
+ * their bounding box; the other file is scattered the same way and the two arrays are compared
+ * with one vectorized scan.
+ *
+ * Values match when |ref - out| <= tol + rel_tol * |ref| and both or neither are zero.
+ *
+ * Result writers may also leave a fingerprint next to the output (see OutputFingerprint). When
+ * both files have one, equal fingerprints decide the comparison without reading either output,
+ * and only differing or missing ones fall back to the full comparison.
+ *
+ * Very large references can opt into sampling (ReferenceOutput::enable_sampling): the other file
+ * is checked at randomly drawn entries only, plus its nnz when both sides have fingerprints, and
+ * any discrepancy escalates to the full comparison.
+ */
+
+// Receives one nonzero: coordinates (rank of them) and value. Returning false stops the scan.
+typedef function<bool(const int64_t* coords, size_t rank, double value)> OutputEntryFn;
+
+/**
+ * Stream the nonzero entries of an output tensor file.
+ * @return false if fn stopped the scan, true if the whole file was read
+ * @throw runtime_error if the file cannot be read or its format is not supported
+ */
+bool for_each_output_entry(const string& path, const OutputEntryFn& fn);
+
+// Cheap upper bound on the entries of a file (data lines of a text file, nnz of a binary one)
+uint64_t output_entry_bound(const string& path);
+
+/**
+ * Compare two value arrays of the same layout element by element, with AVX-512 or AVX2 when the
+ * CPU supports them (picked at runtime) and scalar code otherwise.
+ */
+bool dense_values_match(const double* ref, const double* out, size_t n, double tol, double rel_tol = 0.0);
+
+// Instruction set dense_values_match runs with: "avx512", "avx2" or "scalar"
+const char* dense_compare_isa();
+
+/**
+ * Order-independent summary of an output tensor, written by the result writers next to the file.
+ *
+ * Every nonzero is hashed from its coordinates (as written) and its value rounded to a multiple
+ * of `grid`; the entry hashes are summed, so the writer may emit entries in any order. Two outputs
+ * with equal fingerprints hold the same coordinates and values that round to the same multiple,
+ * i.e. differ by less than grid, which is a match for any tolerance >= grid. Values that straddle
+ * a rounding boundary produce different fingerprints and go through the full comparison.
+ *
+ * File (one line): TSFP1 <grid> <rank> <nnz> <value_hash> <coordinate sum per mode...>
+ * The generated TACO programs and eval_finch.jl compute the same hash; keep them in sync.
+ * Each copy checks itself against FINGERPRINT_TEST_HASH and writes or uses no fingerprints when
+ * it disagrees, so a drifted copy costs full comparisons instead of silently missing every time.
+ */
+// Grid the result writers round values to; it bounds the tolerances fingerprints can decide
+const double FINGERPRINT_GRID = 1e-9;
+// value_hash of the rank-2 entries (0, 1) = 1.5 and (2, 3) = -0.25 (coordinates as written)
+const uint64_t FINGERPRINT_TEST_HASH = 0xE5488BFCFA603D28ULL;
+
+typedef struct OutputFingerprint {
+    double grid = FINGERPRINT_GRID;
+    size_t rank = 0;
+    uint64_t nnz = 0;
+    uint64_t value_hash = 0;
+    vector<uint64_t> coord_sums;    // per mode, wrapping
+    bool valid = true;              // false once a value cannot be rounded to the grid (inf, NaN)
+
+    OutputFingerprint() = default;
+    explicit OutputFingerprint(size_t rank) : rank(rank), coord_sums(rank, 0) {}
+
+    // Zero values are skipped, like in the comparison
+    void add(const int64_t* coords, double value);
+
+    bool operator==(const OutputFingerprint& other) const;
+
+    // Invalid fingerprints are not written
+    bool save(const string& file) const;
+    // @return false if the file is missing or malformed
+    static bool load(const string& file, OutputFingerprint& fp);
+} OutputFingerprint;
+
+// Fingerprint file of an output file: same name with the extension .fp
+string fingerprint_file(const string& output_file);
+
+// Fingerprint of an output file, computed by reading it
+OutputFingerprint fingerprint_output(const string& path, size_t rank, double grid = FINGERPRINT_GRID);
+
+/**
+ * Sampled comparison of large outputs. The sample is sized so that an output in which at least
+ * `error_rate` of the entries are wrong is caught with probability `confidence`:
+ *   n = ln(1 - confidence) / ln(1 - error_rate)
+ * This needs every entry equally likely: text lines are drawn uniformly whatever their length.
+ */
+typedef struct SampleOptions {
+    uint64_t min_nnz = 0;           // sample references with at least this many nonzeros (0 = never)
+    double confidence = 0.999;
+    double error_rate = 1e-4;
+} SampleOptions;
+
+uint64_t sample_size(const SampleOptions& opts);
+
+// How many comparisons were made and how each was decided
+typedef struct CompareStats {
+    uint64_t comparisons;
+    uint64_t fingerprint_hits;
+    uint64_t fingerprint_misses;    // both fingerprints usable and different, yet the outputs matched
+    uint64_t sampled;               // accepted from a sample
+    uint64_t escalated;             // sample found a discrepancy, compared in full
+} CompareStats;
+
+CompareStats compare_stats();
+
+class ReferenceOutput {
+public:
+    /**
+     * The entries are only read on the first comparison that the fingerprints cannot decide.
+     * @param dense_output the output tensor is stored all-Dense, so the flat comparison is used
+     *                     whenever the reference's bounding box is small enough to allocate
+     */
+    explicit ReferenceOutput(const string& path, bool dense_output = false);
+
+    /**
+     * Compare another output file against the reference.
+     * @param tol absolute tolerance
+     * @param rel_tol tolerance relative to the reference value
+     * @throw runtime_error if a file cannot be read
+     */
+    bool matches(const string& kernel_output, double tol, double rel_tol = 0.0) const;
+
+    /**
+     * Accept outputs from a random sample of their entries when the reference has at least
+     * opts.min_nnz nonzeros. Each comparison draws from stream n of `seed` (n counts comparisons).
+     */
+    void enable_sampling(const SampleOptions& opts, uint64_t seed);
+
+    const string& path() const { return path_; }
+    // The accessors below read the entries
+    size_t nnz() const { load(); return unique_nnz_; }          // distinct nonzero coordinates
+    size_t rank() const { load(); return rank_; }
+    bool dense() const { load(); return !dense_.empty(); }       // compared as flat arrays
+
+private:
+    void load() const;
+    void load_entries();
+    // Reference value at these coordinates; false if there is no nonzero there
+    bool lookup(const int64_t* coords, double& value) const;
+    bool sample_matches(const string& kernel_output, const OutputFingerprint* other, double tol, double rel_tol) const;
+    bool entries_match(const string& kernel_output, const OutputFingerprint* other, double tol, double rel_tol) const;
+
+    // Index of the entry with these coordinates, -1 if absent
+    int64_t find(const int64_t* coords) const;
+    bool make_key(const int64_t* coords, uint64_t& key) const;
+
+    string path_;
+    bool dense_output_;
+    OutputFingerprint fingerprint_;
+    bool has_fingerprint_;
+    mutable once_flag loaded_;
+
+    bool sampling_ = false;
+    SampleOptions sample_opts_;
+    uint64_t sample_seed_ = 0;
+    mutable atomic<uint64_t> sample_calls_{0};
+
+    size_t rank_ = 0;
+    vector<int64_t> coords_;        // rank_ per entry
+    vector<double> values_;
+    size_t unique_nnz_ = 0;
+    vector<int64_t> lower_;         // bounding box of the coordinates, per mode
+    vector<uint64_t> extent_;
+    bool linear_keys_ = true;       // keys are exact linear positions; otherwise hashes, checked against coords_
+    vector<uint32_t> slots_;        // open addressing: entry + 1, 0 = empty
+    vector<uint64_t> slot_keys_;
+    vector<double> dense_;          // reference values over the bounding box (dense comparison only)
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+
+#include "tensure/formats.hpp"
+
+/**
+ * Public API of libtensure_core.
+ *
+ * Lets other programs (CI services, notebooks, custom drivers) generate kernels and data,
+ * derive equivalent mutants and compare outputs in-process, without spawning TenSure.
+ * Everything declared here is kept source compatible within a major version; the lower level
+ * headers (random_gen.hpp, utils.hpp) remain available but may change between releases.
+ */
+
+#define TENSURE_CORE_VERSION_MAJOR 1
+#define TENSURE_CORE_VERSION_MINOR 1
+
+namespace tensure {
+using namespace std;
+namespace fs = std::filesystem;
+
+// A generated reference kernel: the kernel specification plus where it was written to
+typedef struct GeneratedKernel {
+    tsKernel kernel;
+    string einsum;
+    fs::path kernel_file;                 // <out_dir>/kernel.json
+    vector<string> data_files;            // one per input tensor
+} GeneratedKernel;
+
+// Options for generate_kernel
+typedef struct GenerateOptions {
+    int num_inputs = 2;                   // number of input tensors
+    int max_rank = 6;                     // maximum rank of any tensor
+    string tensor_file_format = "tns";    // tns|ttx|tsb (binary, see tensor_io.hpp)
+    string sparsity_pattern = "uniform";  // see patterns.hpp, or "random" per tensor
+    uint64_t seed = 0;                    // same seed, same kernel and data; 0 draws from the calling thread's stream
+} GenerateOptions;
+
+// "major.minor" of the linked library (compare against the TENSURE_CORE_VERSION_* macros)
+string version();
+
+/**
+ * Generate a random einsum kernel, its input data and the reference kernel.json in out_dir.
+ * Data files go to out_dir/data.
+ * @throw runtime_error if data or kernel generation fails
+ */
+GeneratedKernel generate_kernel(const fs::path& out_dir, const GenerateOptions& options = GenerateOptions());
+
+/**
+ * Write semantically equivalent mutants of out_dir/<kernel_file> as kernel1.json ... kernelN.json.
+ * @param max_mutants N at most (the fuzzer's --mutants default); fewer when the kernel's mutation space is smaller
+ * @param seed same seed, same mutants; 0 draws from the calling thread's stream
+ * @return kernel file names, the original first
+ */
+vector<string> mutate_kernel(const fs::path& out_dir, const string& kernel_file = "kernel.json", int max_mutants = 10, uint64_t seed = 0);
+
+/**
+ * Compare two output tensor files (.tns, .ttx, .mtx or .tsb) within an absolute tolerance.
+ * @throw runtime_error if either file cannot be read
+ */
+bool compare(const string& ref_output, const string& kernel_output, double tol = 1e-8);
+
+}
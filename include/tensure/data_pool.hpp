@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <condition_variable>
+#include <filesystem>
+#include <cstdint>
+
+#include "tensure/formats.hpp"
+#include "tensure/rng.hpp"
+#include "tensure/patterns.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// One generated input file kept by the pool, keyed by (shape, pattern and its parameters, file format, seed)
+typedef struct PooledTensorFile {
+    vector<int> shape;
+    string pattern;
+    PatternParams params;
+    string tfmt;
+    uint64_t seed;
+    fs::path file;
+    size_t bytes;                   // in-memory size of the data (coordinates + values)
+    shared_future<bool> written;    // the file is complete once this is ready and true
+
+    ~PooledTensorFile();            // evicted entries delete their file
+} PooledTensorFile;
+
+/**
+ * Bounded pool of generated input files shared by all fuzzing jobs.
+ *
+ * acquire() returns a pooled file of the requested shape and pattern with probability reuse_prob,
+ * and otherwise generates a fresh one on the calling thread and adds it to the pool. Every reuse also
+ * queues a refresh of that profile, so background threads keep replacing the oldest entries with new
+ * data (and new files) off the fuzzing jobs' cores. Files live in one directory (a tmpfs one with --shm)
+ * and are hard-linked into the iterations that use them.
+ */
+class TensorDataPool {
+public:
+    /**
+     * @param dir directory for the pooled files (created, and removed with the pool)
+     * @param capacity_bytes bound on the total in-memory size of the pooled data
+     * @param reuse_prob probability that acquire() returns an existing entry when one matches
+     * @param refresh_threads background generators (0 disables the refresh)
+     * @param seed campaign seed; refreshes draw from its DATA_POOL stream
+     */
+    TensorDataPool(const fs::path& dir, size_t capacity_bytes, double reuse_prob, size_t refresh_threads, uint64_t seed);
+    ~TensorDataPool();
+    TensorDataPool(const TensorDataPool&) = delete;
+    TensorDataPool& operator=(const TensorDataPool&) = delete;
+
+    /**
+     * Get a file holding data of the given shape and pattern, reusing a pooled one or generating it.
+     * @param seed seed for the data if a new entry has to be generated
+     * @param gen decides reuse and picks among matching entries
+     * @return entry whose file stays on disk as long as the returned pointer is held
+     */
+    shared_ptr<const PooledTensorFile> acquire(const vector<int>& shape, const string& pattern, const PatternParams& params, const string& tfmt, uint64_t seed, tsRng& gen);
+
+    size_t size();
+    size_t bytes();
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+private:
+    typedef struct Profile {
+        vector<int> shape;
+        string pattern;
+        PatternParams params;
+        string tfmt;
+    } Profile;
+
+    static string profile_key(const Profile& profile);
+    shared_ptr<PooledTensorFile> generate(const Profile& profile, uint64_t seed, bool background);
+    void insert(const string& key, shared_ptr<PooledTensorFile> entry);
+    void refresh_loop();
+
+    fs::path dir_;
+    size_t capacity_bytes_;
+    double reuse_prob_;
+
+    mutex mtx_;
+    condition_variable cv_;
+    map<string, vector<shared_ptr<PooledTensorFile>>> entries_;     // by profile
+    deque<pair<string, shared_ptr<PooledTensorFile>>> order_;       // insertion order, oldest evicted first
+    size_t bytes_ = 0;
+    uint64_t next_file_ = 0;
+    atomic<size_t> hits_{0};
+    atomic<size_t> misses_{0};
+
+    deque<Profile> refresh_queue_;
+    tsRng refresh_gen_;
+    vector<thread> workers_;
+    bool stopping_ = false;
+};
+
+/**
+ * Make `link` refer to the contents of `file`: a hard link when both are on the same file system,
+ * a copy otherwise.
+ */
+bool link_or_copy_file(const fs::path& file, const fs::path& link);
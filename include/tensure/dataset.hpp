@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <random>
+#include <filesystem>
+
+#include "tensure/formats.hpp"
+#include "tensure/tensor_io.hpp"
+#include "tensure/rng.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/**
+ * Real-world input tensors: SuiteSparse matrices (.mtx) and FROSTT tensors (.tns) read from a
+ * local dataset directory. Files are memory-mapped and parsed in parallel, and einsums are
+ * built around them so backends see realistic sparsity at realistic sizes.
+ */
+
+// A tensor loaded from a dataset file, with 0-based coordinates
+typedef struct DatasetTensor {
+    string path;
+    vector<int> shape;
+    tsTensorData data;
+} DatasetTensor;
+
+/**
+ * Load a .mtx (MatrixMarket coordinate; real, integer or pattern; general, symmetric or
+ * skew-symmetric), FROSTT .tns file (1-based coordinates, shape taken from the largest index)
+ * or TenSure binary .tsb file.
+ * @param num_threads parser threads, 0 for one per core
+ * @throw runtime_error on unreadable or malformed files
+ */
+DatasetTensor load_dataset_tensor(const string& path, size_t num_threads = 0);
+
+/**
+ * The .mtx/.tns/.tsb files of a dataset directory (searched recursively). Tensors are loaded on first
+ * use and kept in memory for the rest of the campaign; safe to share between worker threads.
+ */
+class DatasetCatalog {
+public:
+    explicit DatasetCatalog(const fs::path& dir);
+
+    bool empty() const { return files_.empty(); }
+    size_t size() const { return files_.size(); }
+    const vector<string>& files() const { return files_; }
+
+    // @throw runtime_error if the file cannot be loaded
+    shared_ptr<const DatasetTensor> get(size_t i);
+
+    // A uniformly chosen dataset tensor, or nullptr if none of the files could be loaded
+    shared_ptr<const DatasetTensor> pick(tsRng& gen);
+
+private:
+    mutex mtx_;
+    vector<string> files_;
+    map<string, shared_ptr<const DatasetTensor>> cache_;
+};
+
+/**
+ * Build a random einsum with the dataset tensor as input B. Every other input shares exactly one
+ * index with B and the output keeps at most one of B's indices, so no generated tensor is larger than
+ * one dimension of the dataset times a few small dimensions (SpMV, SpMM, TTV, TTM-like kernels).
+ * B stores its first mode in a random format and the others compressed.
+ * @param numInputs number of input tensors, at least 2
+ * @throw runtime_error if the dataset has more than 6 modes
+ */
+tuple<vector<tsTensor>, string> generate_dataset_einsum(const DatasetTensor& dataset, int numInputs, tsRng& gen);
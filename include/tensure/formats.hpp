@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <cstdint>
 #include <algorithm>
 #include <iostream>
 
@@ -87,9 +88,20 @@ inline bool is_equal(const vector<TensorFormat>& fmt1, const vector<TensorFormat
 enum MutationOperator {
     SPARSITY,
     COMMUTATIVITY,
+    SCHEDULE,
     COUNT
 };
 
+inline string to_string(MutationOperator op) {
+    switch (op) {
+        case MutationOperator::SPARSITY:      return "sparsity";
+        case MutationOperator::COMMUTATIVITY: return "commutativity";
+        case MutationOperator::SCHEDULE:      return "schedule";
+        default: break;
+    }
+    return "Unknown";
+}
+
 typedef struct tsTensor
 {
     char name;
@@ -97,44 +109,106 @@ typedef struct tsTensor
     vector<char> idxs;
     vector<int> shape;
     vector<TensorFormat> storageFormat;
+    string sparsityPattern;     // pattern the input data was generated with (see patterns.hpp), empty if unknown
+    double density = 0.0;       // density parameter of that pattern, 0 if unknown
+    vector<bool> pinned;        // modes whose storage format mutations must keep (e.g. Sparse modes of a dataset); empty if none
+
+    bool is_pinned(size_t mode) const { return mode < pinned.size() && pinned[mode]; }
 } tsTensor;
 
 typedef struct tsTensorData
 {
     char tensorName;
-    vector<vector<int>> coordinate;
+    size_t rank = 0;
+    // Structure of arrays: nonzero n has coordinates coordinate[n*rank, (n+1)*rank) and value data[n]
+    vector<int> coordinate;
     vector<double> data;
     string tfmt;
 
-    // Insert: update if coord exists, otherwise push new coord+value
+    void reserve(size_t nnz)
+    {
+        coordinate.reserve(nnz * rank);
+        data.reserve(nnz);
+    }
+
+    // Set the rank and reserve room for the expected nonzeros of a tensor of this shape
+    void reserve(const vector<int>& shape, double density)
+    {
+        rank = shape.size();
+        double volume = 1.0;
+        for (int dim : shape)
+            volume *= dim;
+        reserve(static_cast<size_t>(volume * min(max(density, 0.0), 1.0)));
+    }
+
+    const int* coord(size_t n) const {
+        return coordinate.data() + n * rank;
+    }
+
+    // Append a nonzero without checking for an existing entry (for generators that emit unique coordinates)
+    void append(const int* coord, double value)
+    {
+        coordinate.insert(coordinate.end(), coord, coord + rank);
+        data.push_back(value);
+        if (!index.empty())
+            index_entry(data.size() - 1);
+    }
+
+    // Insert: update if coord exists, otherwise append new coord+value
     void insert(const std::vector<int>& coord, double value)
     {
-        // find existing coordinate (linear search)
-        auto it = std::find_if(coordinate.begin(), coordinate.end(),
-            [&](const vector<int>& c){
-                return c == coord;
-            });
-        
-        if (it != coordinate.end()) {
+        if (data.empty())
+            rank = coord.size();
+        check_rank(coord);
+        if (index.empty())
+            build_index();
+
+        size_t slot = find_slot(coord.data());
+        if (index[slot] != 0) {
             // update the value at the same index
-            size_t idx = std::distance(coordinate.begin(), it);
-            data[idx] = value;
-        } else {
-            // append new coordinate and value
-            coordinate.push_back(coord);
-            data.push_back(value);
+            data[index[slot] - 1] = value;
+            return;
         }
+        coordinate.insert(coordinate.end(), coord.begin(), coord.end());
+        data.push_back(value);
+        index_entry(data.size() - 1);
     }
 
-    // helper: get value at coordinate (throws if not found)
+    /**
+     * Value at a coordinate (throws if not found). Never modifies the tensor, so concurrent calls
+     * are safe: it uses the index when one is built (see build_index) and scans the entries otherwise.
+     */
     double get(const vector<int>& coord) const {
-        auto it = find(coordinate.begin(), coordinate.end(), coord);
-        if (it == coordinate.end()) {
+        check_rank(coord);
+        if (index.empty()) {
+            for (size_t n = 0; n < data.size(); n++)
+                if (equal(coord.begin(), coord.end(), this->coord(n))) return data[n];
             throw out_of_range("Coordinate not found");
         }
 
-        size_t idx = distance(coordinate.begin(), it);
-        return data[idx];
+        size_t entry = index[find_slot(coord.data())];
+        if (entry == 0) {
+            throw out_of_range("Coordinate not found");
+        }
+        return data[entry - 1];
+    }
+
+    // Index the coordinates for get(), e.g. before sharing the tensor between threads
+    void build_index() {
+        size_t capacity = 16;
+        while (capacity < 2 * (data.size() + 1))
+            capacity <<= 1;
+        index.assign(capacity, 0);
+        for (size_t n = 0; n < data.size(); n++) {
+            size_t slot = find_slot(coord(n));
+            if (index[slot] == 0)
+                index[slot] = n + 1;
+        }
+    }
+
+    // Drop the index; required after writing coordinate or data directly rather than through append/insert
+    void invalidate_index() {
+        index.clear();
     }
 
     size_t size() const {
@@ -144,12 +218,105 @@ typedef struct tsTensorData
     void clear() {
         coordinate.clear();
         data.clear();
+        index.clear();
+    }
+
+private:
+    // Open-addressing (linear probing) index over the coordinates: slot -> entry + 1, 0 marks an
+    // empty slot. Built on the first insert or by build_index, so bulk generation via append()
+    // never pays for it.
+    vector<size_t> index;
+
+    void check_rank(const vector<int>& coord) const {
+        if (coord.size() != rank)
+            throw invalid_argument("Coordinate of rank " + std::to_string(coord.size()) + " in a rank " + std::to_string(rank) + " tensor");
+    }
+
+    uint64_t hash(const int* c) const {
+        uint64_t h = 0x9E3779B97F4A7C15ull;
+        for (size_t d = 0; d < rank; d++) {
+            h ^= static_cast<uint32_t>(c[d]);
+            h *= 0xBF58476D1CE4E5B9ull;
+            h ^= h >> 31;
+        }
+        return h;
+    }
+
+    size_t find_slot(const int* c) const {
+        size_t mask = index.size() - 1;
+        size_t slot = hash(c) & mask;
+        while (index[slot] != 0 && !equal(c, c + rank, coord(index[slot] - 1)))
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    // Keep the load factor at or below 1/2
+    void index_entry(size_t n) {
+        if (2 * (n + 1) > index.size()) {
+            build_index();
+            return;
+        }
+        size_t slot = find_slot(coord(n));
+        if (index[slot] == 0)
+            index[slot] = n + 1;
     }
 
 } tsTensorData;
 
+/**
+ * One transformation of TACO's scheduling language, applied to the concrete index statement of a
+ * computation. vars holds the index variables it names, new ones included:
+ *   split       {i, i0, i1}, factor      reorder   the new loop order
+ *   pos         {i, ipos}, tensor        unroll    {i}, factor
+ *   precompute  {i}: the right-hand side into a dense workspace over i, the innermost output
+ *               index of the concrete statement (the other output indices enclose it)
+ *   parallelize {i}, source: on CPU threads, atomics if source is a reduction variable
+ */
+typedef struct tsScheduleCommand {
+    string command;
+    vector<string> vars;
+    string tensor;
+    int factor = 0;
+    string source;      // index of the kernel that vars[0] was derived from (empty for reorder)
+} tsScheduleCommand;
+
+inline string to_string(const tsScheduleCommand& cmd) {
+    string s = cmd.command + "(";
+    for (size_t i = 0; i < cmd.vars.size(); i++)
+        s += (i ? "," : "") + cmd.vars[i];
+    if (!cmd.tensor.empty()) s += "," + cmd.tensor;
+    if (cmd.factor > 0) s += "," + std::to_string(cmd.factor);
+    return s + ")";
+}
+
+inline string to_string(const vector<tsScheduleCommand>& schedule) {
+    string s;
+    for (size_t i = 0; i < schedule.size(); i++)
+        s += (i ? ";" : "") + to_string(schedule[i]);
+    return s;
+}
+
 typedef struct tsComputation {
     string expressions;
+    vector<tsScheduleCommand> schedule;     // empty: the backend's default schedule
+
+    // Parse one entry of the "computations" array of a kernel JSON
+    static tsComputation from_json(const json& c)
+    {
+        tsComputation comp;
+        comp.expressions = c["expression"].get<string>();
+        for (auto &jc : c.value("schedule", json::array()))
+        {
+            tsScheduleCommand cmd;
+            cmd.command = jc["command"].get<string>();
+            cmd.vars = jc["vars"].get<vector<string>>();
+            cmd.tensor = jc.value("tensor", "");
+            cmd.factor = jc.value("factor", 0);
+            cmd.source = jc.value("source", "");
+            comp.schedule.push_back(cmd);
+        }
+        return comp;
+    }
 } tsComputation;
 
 typedef struct tsKernel
@@ -158,13 +325,13 @@ typedef struct tsKernel
     map<string, string> dataFileNames;
     vector<tsComputation> computations;
 
-    void saveJson(const string& file_name)
+    void saveJson(const string& file_name) const
     {
         json j;
 
         // Serialize tensors
         j["tensors"] = json::array();
-        for (auto &tensor : tensors)
+        for (const auto &tensor : tensors)
         {
             json t;
             t["name"] = string(1, tensor.name);
@@ -172,6 +339,15 @@ typedef struct tsKernel
             t["str_repr"] = tensor.str_repr;
             t["idxs"] = tensor.idxs;
             t["storageFormat"] = to_string(tensor.storageFormat);
+            if (!tensor.sparsityPattern.empty())
+                t["sparsityPattern"] = tensor.sparsityPattern;
+            if (tensor.density > 0.0)
+                t["density"] = tensor.density;
+            vector<size_t> pinned_modes;
+            for (size_t d = 0; d < tensor.pinned.size(); d++)
+                if (tensor.pinned[d]) pinned_modes.push_back(d);
+            if (!pinned_modes.empty())
+                t["pinnedModes"] = pinned_modes;
             
             // Loopup file path using the tensor's name
             auto it = dataFileNames.find(string(1, tensor.name));
@@ -182,10 +358,27 @@ typedef struct tsKernel
 
         // Serialize computations
         j["computations"] = json::array();
-        for (auto &c : computations)
+        for (const auto &c : computations)
         {
             json comp;
             comp["expression"] = c.expressions;
+            if (!c.schedule.empty())
+            {
+                comp["schedule"] = json::array();
+                for (const auto &cmd : c.schedule)
+                {
+                    json jc;
+                    jc["command"] = cmd.command;
+                    jc["vars"] = cmd.vars;
+                    if (!cmd.tensor.empty())
+                        jc["tensor"] = cmd.tensor;
+                    if (cmd.factor > 0)
+                        jc["factor"] = cmd.factor;
+                    if (!cmd.source.empty())
+                        jc["source"] = cmd.source;
+                    comp["schedule"].push_back(jc);
+                }
+            }
             j["computations"].push_back(comp);
         }
 
@@ -220,6 +413,14 @@ typedef struct tsKernel
             tensor.idxs = t["idxs"].get<vector<char>>();
             tensor.str_repr = t["str_repr"].get<string>();
             tensor.storageFormat = parseTensorFormat(t["storageFormat"].get<vector<string>>());
+            tensor.sparsityPattern = t.value("sparsityPattern", "");
+            tensor.density = t.value("density", 0.0);
+            for (size_t d : t.value("pinnedModes", vector<size_t>()))
+            {
+                if (d >= tensor.storageFormat.size()) continue;
+                tensor.pinned.resize(tensor.storageFormat.size(), false);
+                tensor.pinned[d] = true;
+            }
 
             tensors.push_back(tensor);
 
@@ -231,10 +432,6 @@ typedef struct tsKernel
 
         // Deserialize computations
         for (auto &c : j["computations"])
-        {
-            tsComputation comp;
-            comp.expressions = c["expression"].get<string>();
-            computations.push_back(comp);
-        }
+            computations.push_back(tsComputation::from_json(c));
     }
 } tsKernel;
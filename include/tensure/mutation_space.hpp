@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <cstdint>
+
+#include "tensure/formats.hpp"
+#include "tensure/rng.hpp"
+
+using namespace std;
+
+/**
+ * The equivalent mutants of a kernel as one enumerable space: every storage format of every tensor
+ * (SPARSITY) combined with every order of the inputs (COMMUTATIVITY).
+ *
+ * A kernel of the space is identified by its rank, a mixed-radix number with one digit per
+ * operator: the format digit has one bit per mode of every tensor (1 = Dense), in the order of the
+ * original kernel's tensors and modes, and the order digit is the Lehmer code of the permutation of
+ * the inputs. Pinned modes (tsTensor::pinned) keep their format and have no bit. rank = order * 2^(modes) + formats; the original kernel has rank 0 in the order digit.
+ *
+ * draw() picks unseen ranks uniformly by a Fisher-Yates shuffle of [0, size) that only stores the
+ * positions it has swapped, so each draw is O(1) and never repeats a kernel. draw(op) changes only
+ * the digit of one operator in a kernel drawn before (the original included), with one such
+ * shuffle per operator and value of the other digits. Spaces too large for 64-bit ranks are
+ * sampled directly instead, and duplicates (practically absent there) are skipped.
+ *
+ * SCHEDULE is not a digit of the rank: draw(SCHEDULE) attaches a random schedule (random_schedule)
+ * to a kernel drawn before, so its radix is unbounded and it never exhausts the space.
+ */
+class MutationSpace {
+public:
+    explicit MutationSpace(const tsKernel& original);
+
+    // Kernels in the space, the original included; UINT64_MAX if it does not fit in 64 bits
+    uint64_t size() const { return size_; }
+    // Mutants not drawn yet; UINT64_MAX for spaces too large to enumerate
+    uint64_t remaining() const { return remaining_; }
+
+    // Number of values of one operator's digit (1 if the operator cannot change this kernel, UINT64_MAX if unbounded)
+    uint64_t radix(MutationOperator op) const;
+
+    /**
+     * Draw a kernel of the space that differs from the original and from every earlier draw.
+     * @return false once the space is exhausted
+     */
+    bool draw(tsRng& gen, tsKernel& mutant);
+
+    /**
+     * Draw a kernel that differs from a random earlier draw (or the original) in the digit of `op`
+     * only, and from every earlier draw.
+     * @return false once no earlier kernel has an unseen value of that digit
+     */
+    bool draw(tsRng& gen, MutationOperator op, tsKernel& mutant);
+
+    // Kernel of a rank (< size()), and back
+    tsKernel unrank(uint64_t rank) const;
+    uint64_t rank(const tsKernel& kernel) const;
+
+private:
+    // Fisher-Yates shuffle of [0, size) that stores only the positions it has swapped
+    typedef struct Shuffle {
+        uint64_t remaining = 0;
+        unordered_map<uint64_t, uint64_t> swaps;
+
+        explicit Shuffle(uint64_t size = 0) : remaining(size) {}
+        uint64_t at(uint64_t pos) const;
+        uint64_t next(tsRng& gen);
+    } Shuffle;
+
+    uint64_t digits_to_rank(uint64_t format_digit, uint64_t order_digit) const { return (order_digit << modes_) | format_digit; }
+    tsKernel random_kernel(tsRng& gen, bool formats, bool order) const;
+    tsKernel build(const vector<vector<TensorFormat>>& formats, const vector<size_t>& order) const;
+
+    tsKernel original_;
+    size_t modes_ = 0;              // unpinned modes over all tensors: bits of the format digit
+    vector<string> terms_;          // input terms of the expression, in the original order
+    string lhs_;
+    uint64_t orders_ = 1;           // (inputs)! if the expression can be reordered, 1 otherwise
+    uint64_t size_ = 1;
+    uint64_t remaining_ = 0;
+    bool enumerable_ = true;
+    bool schedulable_ = false;      // one computation with at least one loop
+
+    Shuffle all_;                               // joint draws
+    map<pair<int, uint64_t>, Shuffle> digit_;   // draw(op): (op, other digit) -> values of op's digit
+    vector<uint64_t> drawn_;                    // ranks drawn so far, the original first
+    unordered_set<uint64_t> seen_;              // ranks of drawn_; kernel_hash of the draws for spaces not enumerable
+    unordered_set<uint64_t> scheduled_;         // kernel_hash of the scheduled draws
+};
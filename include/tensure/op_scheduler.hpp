@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+#include "tensure/formats.hpp"
+#include "tensure/rng.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * Adaptive choice of the mutation operator applied to derive each mutant.
+ *
+ * Every operator is an arm of a multi-armed bandit. A mutant earns its operator a reward for the
+ * bugs it exposed, for emitted code no earlier mutant produced and for running far slower than its
+ * siblings (performance outliers), and the reward is divided by the wall time the mutant ran. UCB1
+ * then picks the operator with the best normalised reward rate plus an exploration bonus; operators
+ * never tried come first. The statistics are shared by all jobs and can be saved and loaded, so a
+ * campaign resumes with what earlier campaigns learned.
+ */
+
+enum class SchedulerPolicy {
+    UNIFORM,        // every applicable operator equally likely, as before the scheduler
+    UCB             // UCB1 on reward per wall-clock second
+};
+
+string to_string(SchedulerPolicy policy);
+SchedulerPolicy parseSchedulerPolicy(const string& s);
+
+// What running one mutant produced
+typedef struct MutantOutcome {
+    bool bug = false;               // crash or wrong code
+    bool new_code = false;          // emitted code whose hash had not been seen
+    bool outlier = false;           // much slower than the other mutants of its kernel
+    double wall_seconds = 0.0;      // time the mutant took to compile and run
+} MutantOutcome;
+
+typedef struct OperatorStats {
+    uint64_t pulls = 0;             // mutants derived with the operator and run
+    double reward = 0.0;
+    double wall_seconds = 0.0;
+    uint64_t bugs = 0;
+    uint64_t new_code = 0;
+    uint64_t outliers = 0;
+
+    double reward_rate() const { return wall_seconds > 0 ? reward / wall_seconds : 0.0; }
+} OperatorStats;
+
+class OperatorScheduler {
+public:
+    // Reward of one outcome of each kind
+    static constexpr double BUG_REWARD = 10.0;
+    static constexpr double NEW_CODE_REWARD = 1.0;
+    static constexpr double OUTLIER_REWARD = 2.0;
+
+    explicit OperatorScheduler(SchedulerPolicy policy = SchedulerPolicy::UNIFORM);
+
+    // Never pick op, e.g. SCHEDULE when no backend applies schedules
+    void disable(MutationOperator op);
+
+    /**
+     * Choose among the enabled operators with available[op] set.
+     * @return COUNT if none is available
+     */
+    MutationOperator pick(tsRng& gen, const vector<bool>& available);
+
+    void update(MutationOperator op, const MutantOutcome& outcome);
+
+    // Statistics, as JSON ({"operators": {"<name>": {...}}}) or one line per operator
+    json to_json();
+    string report();
+    void save(const string& file);
+    // Add the statistics of a file saved earlier; throws runtime_error if it cannot be read
+    void load(const string& file);
+
+    SchedulerPolicy policy() const { return policy_; }
+
+private:
+    SchedulerPolicy policy_;
+    mutex mtx_;
+    vector<OperatorStats> stats_;
+    vector<bool> enabled_;
+};
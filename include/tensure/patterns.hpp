@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <random>
+#include <functional>
+
+#include "tensure/formats.hpp"
+#include "tensure/rng.hpp"
+
+using namespace std;
+
+/**
+ * Sparsity pattern library for input generation.
+ *
+ * A pattern decides where the nonzeros of a generated input tensor go. Besides the uniform
+ * Bernoulli(0.4) fill, the built-in patterns produce the skewed structures that exercise the
+ * format-dependent iteration and merge code of sparse tensor compilers:
+ *   uniform       every position nonzero with probability 0.4
+ *   hyper-sparse  every position nonzero with probability 0.01 (often empty)
+ *   empty         no nonzeros at all
+ *   diagonal      positions whose coordinates are all equal
+ *   banded        positions with all coordinates within a random bandwidth (0-2) of each other
+ *   block         dense 2^rank blocks, each present with probability 0.3
+ *   power-law     slices along mode 0 with densities decaying as a power law (one dense slice)
+ *   empty-slice   uniform, but about half of the slices along mode 0 are empty and one is dense
+ *
+ * The densities above are the defaults; PatternParams scales them (density replaces the 0.4 of
+ * uniform and empty-slice, hyper-sparse uses density / 40, banded keeps each band position and
+ * block each block with density / 0.4 times its default, capped at 1) and sets the value range.
+ * Every pattern visits only the positions it may fill, so all of them scale to large tensors.
+ *
+ * New patterns can be registered at runtime with register_sparsity_pattern.
+ */
+
+// Density and value range of one generated input
+typedef struct PatternParams {
+    double density = 0.4;
+    double value_min = 0.0;         // values are uniform in [value_min, value_max), rounded to two decimals
+    double value_max = 0.5;
+
+    bool operator==(const PatternParams& other) const
+    {
+        return density == other.density && value_min == other.value_min && value_max == other.value_max;
+    }
+} PatternParams;
+
+// Densities drawn from a range take 4 values per decade, so equal inputs recur (see data_pool.hpp)
+const int DENSITY_STEPS_PER_DECADE = 4;
+
+// Ranges the PatternParams of each generated input are drawn from (see profile.hpp)
+typedef struct DataProfile {
+    double density_min = 0.4;       // density is log-uniform in [density_min, density_max], rounded
+    double density_max = 0.4;       // to DENSITY_STEPS_PER_DECADE
+    double value_min = 0.0;
+    double value_max = 0.5;
+
+    PatternParams sample(tsRng& gen) const;
+} DataProfile;
+
+// Fills tensorData (rank already set, empty) for the given tensor; must be deterministic in gen
+typedef function<void(const tsTensor& tensor, tsTensorData& tensorData, tsRng& gen, const PatternParams& params)> PatternFillFn;
+
+// Campaign setting that draws a pattern per tensor instead of using a fixed one
+const string RANDOM_SPARSITY_PATTERN = "random";
+
+/**
+ * Register (or replace) a sparsity pattern.
+ * @param name name used on the command line and recorded in kernel.json
+ * @param fn fill function
+ */
+void register_sparsity_pattern(const string& name, PatternFillFn fn);
+
+// Names of all registered patterns, sorted
+vector<string> sparsity_pattern_names();
+
+bool is_sparsity_pattern(const string& name);
+
+// Draw one of the registered patterns uniformly
+string random_sparsity_pattern(tsRng& gen);
+
+/**
+ * Fill tensorData with a tensor of the given pattern. Coordinates come out in row-major order.
+ * @param pattern registered pattern name
+ * @param seed the same seed always produces the same tensor
+ * @param params density and value range
+ * @throw runtime_error if the pattern is unknown
+ */
+void fill_pattern_tensor_data(const tsTensor& tensor, tsTensorData& tensorData, const string& pattern, uint64_t seed, const PatternParams& params = PatternParams());
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "tensure/rng.hpp"
+#include "tensure/patterns.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * Campaign profiles: named sets of generation parameters (number of inputs, ranks, index names,
+ * dimension sizes, densities and values), so that a campaign can target e.g. large dimensions or
+ * high nnz instead of the small default kernels.
+ *
+ * Profiles are read from a JSON file of the form
+ *   { "profiles": { "<name>": { ...fields of CampaignProfile, all optional... }, ... } }
+ * where missing fields keep their defaults. The built-in "default" profile reproduces the
+ * historical generator: 2-5 inputs, rank up to 6, indices "ijklmn", dimensions 3-6, density 0.4.
+ */
+
+typedef struct DimensionProfile {
+    int min = 3;
+    int max = 6;
+    bool log_uniform = false;           // uniform in log space instead of linear (for wide ranges)
+    vector<int> boundaries;             // sizes drawn with boundary_prob instead (cache-line multiples, powers of two)
+    double boundary_prob = 0.0;
+    int boundary_jitter = 1;            // a boundary b yields b - jitter .. b + jitter
+    uint64_t max_tensor_volume = 0;     // shrink dimensions until every tensor fits (0 = unbounded)
+    uint64_t max_dense_volume = 0;      // pin the largest modes Sparse until the others fit (0 = unbounded)
+} DimensionProfile;
+
+typedef struct CampaignProfile {
+    string name = "default";
+    int min_inputs = 2;
+    int max_inputs = 5;
+    int max_rank = 6;                   // rank drawn per input; sharing a contraction index may add to it
+    string index_pool = "ijklmn";
+    DimensionProfile dims;
+    DataProfile data;
+
+    json to_json() const;
+    // Fields missing from j keep their defaults
+    static CampaignProfile from_json(const string& name, const json& j);
+} CampaignProfile;
+
+/**
+ * Load profile `name` from a profiles file. "default" is always available, even without a file.
+ * @throw runtime_error if the file cannot be read, the profile does not exist or a field is invalid
+ */
+CampaignProfile load_campaign_profile(const string& profiles_file, const string& name);
+
+// Names of the profiles defined in a profiles file
+vector<string> campaign_profile_names(const string& profiles_file);
+
+// Draw one dimension size
+int sample_dimension(const DimensionProfile& dims, tsRng& gen);
@@ -12,28 +12,102 @@
 #include "tensure/formats.hpp"
 #include "tensure/utils.hpp"
 #include "tensure/logger.hpp"
+#include "tensure/rng.hpp"
+#include "tensure/patterns.hpp"
+#include "tensure/profile.hpp"
+#include "tensure/dataset.hpp"
+#include "tensure/data_pool.hpp"
+#include "tensure/op_scheduler.hpp"
 
 using namespace std;
 
 /**
- * Map each index to a random value between 3 and 20.
+ * Map each index to a random dimension size drawn from dims (3 to 6 by default).
  * This is used to define the dimensions of the tensors.
  * @param idxs Set of indices
+ * @param gen Random number generator
+ * @param dims dimension distribution of the campaign profile
  * @return Map of index to random value
  */
-map<char, int> map_id_to_val(const std::vector<char>& idxs);
+map<char, int> map_id_to_val(const std::vector<char>& idxs, tsRng& gen, const DimensionProfile& dims = DimensionProfile());
 
 /**
  * Utility: Randomly return whether a tensor dimension is sparse or dense.
  * @param gen Random number generator
  * @return TensorFormat (tSparse or tDense)
  */
-TensorFormat random_format(mt19937& gen);
+TensorFormat random_format(tsRng& gen);
 
 
-tuple<vector<tsTensor>, std::string> generate_random_einsum(int numInputs, int maxRank);
+/**
+ * Generate a random einsum with numInputs inputs over the indices of pool.
+ * @param maxRank maximum rank of any tensor (at most the size of pool)
+ * @param dims distribution of the dimension sizes (see profile.hpp)
+ */
+tuple<vector<tsTensor>, std::string> generate_random_einsum(int numInputs, int maxRank, tsRng& gen, const std::string& pool = "ijklmn", const DimensionProfile& dims = DimensionProfile());
 tuple<vector<tsTensor>, std::string> generate_random_einsum(const std::string filename_suffix);
 
-vector<string> generate_random_tensor_data(const vector<tsTensor>& tensors, string location, string file_name_suffix, string tfmt);
+/**
+ * Fill tensorData with the nonzeros of a random tensor: each position is nonzero with probability
+ * density, values are uniform in [value_min, value_max) with two decimals. Positions are sampled
+ * directly, so the cost is O(nnz) rather than O(volume), and tensors with many positions are sampled
+ * on helper threads from a budget of one per core shared by all callers. Coordinates come out in
+ * row-major order.
+ * @param tensor tensor whose shape to fill
+ * @param tensorData output, cleared first
+ * @param density probability that a position is nonzero
+ * @param seed the same seed always produces the same tensor
+ */
+void fill_random_tensor_data(const tsTensor& tensor, tsTensorData& tensorData, double density, uint64_t seed, double value_min = 0.0, double value_max = 0.5);
+
+/**
+ * Generate and save the data of every input tensor (tensors[1..]) into location.
+ * @param gen draws the pattern (with "random") and the seed of each input
+ * @param pattern sparsity pattern name (see patterns.hpp), or "random" to draw one per tensor;
+ *                the pattern used is stored in each tensor's sparsityPattern
+ * @param fixed_data inputs whose data is given (loaded datasets); saved as-is with pattern "dataset:<path>"
+ * @param pool if given, generated inputs are drawn from (and added to) this pool and linked into location
+ * @param data_profile density and value ranges; the density drawn is stored in each tensor's density
+ * @return data file names, one per input tensor (fewer if saving failed)
+ */
+vector<string> generate_random_tensor_data(vector<tsTensor>& tensors, string location, string file_name_suffix, string tfmt, tsRng& gen, const string& pattern = "uniform", const map<char, const DatasetTensor*>& fixed_data = {}, TensorDataPool* pool = nullptr, const DataProfile& data_profile = DataProfile());
+
+/**
+ * 64-bit structural hash of a kernel: the order, names, indices and formats of its tensors and its
+ * expressions (ignoring whitespace). Mutants are deduplicated on it.
+ */
+uint64_t kernel_hash(const tsKernel& kernel);
 
-vector<string> mutate_equivalent_kernel(const fs::path& directory, const string& original_kernel_filename, int max_mutants = -1);
\ No newline at end of file
+/**
+ * Draw a random schedule for the computation of a kernel (see tsScheduleCommand): optionally a
+ * precompute and a pos, up to two splits, a reorder, an unroll and a parallelize, in the order TACO
+ * applies them. Commands only name index variables that exist in the concrete statement at their
+ * point; TACO itself rejects the ones its checks do not allow.
+ * @return empty if the kernel has no loops to schedule
+ */
+vector<tsScheduleCommand> random_schedule(const tsKernel& kernel, tsRng& gen);
+
+/**
+ * Derive up to max_mutants distinct, semantically equivalent mutants of a kernel, in memory, drawn
+ * without replacement from its MutationSpace (see mutation_space.hpp). Kernels whose space holds
+ * fewer mutants get all of them.
+ * @return the original first, then the mutants
+ */
+vector<tsKernel> mutate_equivalent_kernels(const tsKernel& original, tsRng& gen, int max_mutants);
+
+/**
+ * Derive up to max_mutants distinct equivalent mutants, each by one operator chosen by the
+ * scheduler and applied to the original or to an earlier mutant (see MutationSpace::draw(op)).
+ * @param ops output, the operator of each kernel (COUNT for the original)
+ */
+vector<tsKernel> mutate_equivalent_kernels(const tsKernel& original, tsRng& gen, int max_mutants, OperatorScheduler& scheduler, vector<MutationOperator>& ops);
+
+// File names of `count` kernels: directory/original_kernel_filename, then directory/kernel<i>.json
+vector<string> mutant_kernel_files(const fs::path& directory, const string& original_kernel_filename, size_t count);
+
+/**
+ * mutate_equivalent_kernels on directory/original_kernel_filename, with the mutants saved as
+ * directory/kernel<i>.json.
+ * @return kernel file names, the original first
+ */
+vector<string> mutate_equivalent_kernel(const fs::path& directory, const string& original_kernel_filename, tsRng& gen, int max_mutants = 10);
\ No newline at end of file
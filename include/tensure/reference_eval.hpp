@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "tensure/formats.hpp"
+
+using namespace std;
+
+/**
+ * In-process reference for the generated kernels: A(out) = B(...) * C(...) * ..., summed over
+ * every index that does not appear in A, evaluated directly on the kernel's input files.
+ *
+ * Inputs are scattered into dense row-major arrays and the whole iteration space is walked by a
+ * loop nest specialized at compile time for 1 to 6 indices (a generic nest handles more). Loops
+ * are pruned as soon as a fully indexed input is zero, and the innermost loop multiplies whole
+ * rows of the inputs into a buffer, which the compiler vectorizes. This makes it an independent
+ * oracle for small and medium kernels that costs no compilation.
+ *
+ * Kernels whose iteration space is too large for that are evaluated sparsely instead: every input
+ * is kept as sorted COO, indices used by a single operand are summed out first, and the operands
+ * are then contracted two at a time in the order picked by a greedy cost model in the style of
+ * opt_einsum, with sizes estimated from nnz and the extents of the shared indices. Each pairwise
+ * contraction co-iterates both operands sorted by their shared indices, split across threads.
+ */
+
+typedef struct EinsumEvalLimits {
+    uint64_t max_work = 1ull << 28;             // iteration space: product of all index extents
+    uint64_t max_tensor_volume = 1ull << 24;    // any input or the output, in elements
+    uint64_t max_sparse_work = 1ull << 28;      // products formed by one pairwise contraction (sparse)
+    size_t threads = 1;                         // threads of a pairwise contraction (sparse)
+} EinsumEvalLimits;
+
+/**
+ * Evaluate kernel.computations on the input files of kernel.dataFileNames (0-based coordinates,
+ * as generated).
+ * @param result dense row-major values of the output tensor (kernel.tensors[0])
+ * @return false if the kernel is not a product einsum or exceeds the limits
+ * @throw runtime_error if an input file cannot be read or holds coordinates outside its shape
+ */
+bool evaluate_einsum(const tsKernel& kernel, vector<double>& result, const EinsumEvalLimits& limits = EinsumEvalLimits());
+
+/**
+ * Evaluate kernel.computations sparsely, for any size as long as every operand's index space can
+ * be linearized in 64 bits.
+ * @param result nonzeros of the output tensor, 0-based, in row-major order
+ * @return false if the kernel is not a product einsum or a contraction exceeds max_sparse_work
+ * @throw runtime_error if an input file cannot be read or holds coordinates outside its shape
+ */
+bool evaluate_einsum_sparse(const tsKernel& kernel, tsTensorData& result, const EinsumEvalLimits& limits = EinsumEvalLimits());
+
+/**
+ * Write a result like the backends write theirs: nonzeros only, 1-based .tns, with a fingerprint
+ * next to it.
+ */
+bool write_reference_result(const vector<int>& shape, const vector<double>& values, const string& file);
+// @param result 0-based nonzeros, as returned by evaluate_einsum_sparse
+bool write_reference_result(const vector<int>& shape, const tsTensorData& result, const string& file);
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+using namespace std;
+
+/**
+ * Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+ *
+ * The n-th output block is a pure function of (key, stream, n), so constructing a generator costs a
+ * few stores and any number of independent streams can be derived from one seed without them
+ * overlapping. Satisfies UniformRandomBitGenerator, so it works with the <random> distributions.
+ */
+class Philox4x32 {
+public:
+    typedef uint64_t result_type;
+
+    explicit Philox4x32(uint64_t seed = 0, uint64_t stream = 0) { this->seed(seed, stream); }
+
+    void seed(uint64_t seed, uint64_t stream = 0)
+    {
+        key_[0] = static_cast<uint32_t>(seed);
+        key_[1] = static_cast<uint32_t>(seed >> 32);
+        stream_ = stream;
+        block_ = 0;
+        next_ = 2;
+    }
+
+    result_type operator()()
+    {
+        if (next_ == 2)
+        {
+            generate_block();
+            next_ = 0;
+        }
+        return out_[next_++];
+    }
+
+    void discard(uint64_t n)
+    {
+        for (; n > 0 && next_ < 2; n--)
+            next_++;
+        block_ += n / 2;
+        if (n % 2)
+        {
+            generate_block();
+            next_ = 1;
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return numeric_limits<result_type>::max(); }
+
+private:
+    void generate_block()
+    {
+        uint32_t ctr[4] = {static_cast<uint32_t>(block_), static_cast<uint32_t>(block_ >> 32),
+                           static_cast<uint32_t>(stream_), static_cast<uint32_t>(stream_ >> 32)};
+        uint32_t k0 = key_[0], k1 = key_[1];
+        for (int round = 0; round < 10; round++)
+        {
+            uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * ctr[0];
+            uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * ctr[2];
+            uint32_t next[4] = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ k0, static_cast<uint32_t>(p1),
+                                static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ k1, static_cast<uint32_t>(p0)};
+            ctr[0] = next[0]; ctr[1] = next[1]; ctr[2] = next[2]; ctr[3] = next[3];
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        out_[0] = (static_cast<uint64_t>(ctr[1]) << 32) | ctr[0];
+        out_[1] = (static_cast<uint64_t>(ctr[3]) << 32) | ctr[2];
+        block_++;
+    }
+
+    uint32_t key_[2];
+    uint64_t stream_;
+    uint64_t block_;
+    uint64_t out_[2];
+    int next_;
+};
+
+// Generator used for every random decision in TenSure
+typedef Philox4x32 tsRng;
+
+// Independent stages of a fuzzing job; each gets its own stream so that changing how much
+// randomness one stage consumes never shifts the decisions of another
+enum class RngStage : uint64_t {
+    EINSUM = 0,         // kernel structure, shapes, formats, dataset choice
+    TENSOR_DATA = 1,    // input patterns and values
+    MUTATION = 2,       // mutant kernels
+    DATA_POOL = 3,      // background refresh of the input pool
+    COMPARISON = 4,     // sampled output comparisons
+};
+
+// Seed every job stream derives from (FUZZ_SEED); set once before any job starts
+void set_campaign_seed(uint64_t seed);
+uint64_t campaign_seed();
+
+// Stream of one stage of one fuzzing iteration: a pure function of (campaign seed, iteration, stage)
+tsRng job_rng(uint64_t iteration, RngStage stage);
+
+/**
+ * Per-thread generator for callers outside a fuzzing job (library entry points, tools).
+ * Each thread gets its own stream of the campaign seed, distinct from all job streams.
+ */
+tsRng& thread_rng();
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <deque>
+#include <condition_variable>
+#include <cstdint>
+
+#include "tensure/formats.hpp"
+
+using namespace std;
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    explicit MappedFile(const string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * TenSure binary tensor format (.tsb). Every section starts on a 64-byte boundary, so a reader can
+ * use the arrays in place from an mmap of the file:
+ *   TensorBinaryHeader                  64 bytes
+ *   int64_t  shape[rank]
+ *   int32_t  coords_d[nnz]              one array per mode d = 0 .. rank-1
+ *   double   values[nnz]
+ * Little-endian. Coordinates are stored as index_base-based (0 for inputs, 1 for backend results,
+ * matching the text files they replace).
+ */
+const size_t TSB_ALIGNMENT = 64;
+const char TSB_MAGIC[8] = {'T', 'S', 'U', 'R', 'E', 'T', 'S', 'B'};
+const uint32_t TSB_VERSION = 1;
+
+typedef struct TensorBinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t rank;
+    uint64_t nnz;
+    uint32_t index_base;
+    uint8_t reserved[36];
+} TensorBinaryHeader;
+static_assert(sizeof(TensorBinaryHeader) == TSB_ALIGNMENT, "TensorBinaryHeader must fill one aligned block");
+
+inline uint64_t tsb_align(uint64_t bytes) {
+    return (bytes + TSB_ALIGNMENT - 1) / TSB_ALIGNMENT * TSB_ALIGNMENT;
+}
+
+// Read-only view of a .tsb file; the arrays point into the mapping
+class MappedTensorFile {
+public:
+    // @throw runtime_error if the file cannot be mapped, has a bad header or is truncated
+    explicit MappedTensorFile(const string& path);
+
+    uint32_t rank() const { return header_->rank; }
+    uint64_t nnz() const { return header_->nnz; }
+    uint32_t index_base() const { return header_->index_base; }
+    int64_t shape(size_t d) const { return shape_[d]; }
+    const int32_t* coords(size_t d) const { return coords_[d]; }
+    const double* values() const { return values_; }
+
+private:
+    MappedFile file_;
+    const TensorBinaryHeader* header_;
+    const int64_t* shape_;
+    vector<const int32_t*> coords_;
+    const double* values_;
+};
+
+/**
+ * Save tensor data as .tsb.
+ * @param index_base base of the coordinates in data (recorded in the header)
+ */
+bool save_tensor_binary(const vector<int>& shape, const tsTensorData& data, const string& filename, uint32_t index_base = 0);
+
+/**
+ * Buffered text output for tensor files. Numbers are formatted with std::to_chars straight into
+ * one large reusable buffer, which is handed to write(2) whenever it fills up: no locale, no
+ * stream state and no allocation per entry. Doubles use the shortest representation that
+ * round-trips exactly.
+ */
+class TensorTextWriter {
+public:
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+    TensorTextWriter();
+    ~TensorTextWriter();
+    TensorTextWriter(const TensorTextWriter&) = delete;
+    TensorTextWriter& operator=(const TensorTextWriter&) = delete;
+
+    // Truncate/create the file; false if it cannot be opened
+    bool open(const string& filename);
+    // Flush and close; false if any write failed
+    bool close();
+
+    void put(int value);
+    void put(uint64_t value);
+    void put(double value);
+    void put(char c);
+    void put(const string& s);
+
+    // Bytes handed to the kernel since open()
+    uint64_t bytes_written() const { return bytes_written_; }
+
+private:
+    // Room for the longest number (or character) we write in one go
+    void reserve(size_t n) {
+        if (BUFFER_SIZE - used_ < n)
+            flush();
+    }
+    void flush();
+
+    int fd_ = -1;
+    bool failed_ = false;
+    vector<char> buffer_;
+    size_t used_ = 0;
+    uint64_t bytes_written_ = 0;
+};
+
+/**
+ * Save tensor data as .tns (coordinates and value per line), .ttx (MatrixMarket-style header
+ * with the shape and nnz) or .tsb (binary). Coordinates are written as stored (0-based for generated data).
+ * Uses a per-thread writer, so repeated saves reuse the same buffer.
+ * @return false if tfmt is unknown or the file cannot be written
+ */
+bool save_tensor_data(const vector<int>& shape, const tsTensorData& data, const string& filename, const string& tfmt);
+
+/**
+ * Writes tensor files on background threads so that generation does not wait on the disk.
+ * submit() returns immediately; the future reports whether the file was written.
+ */
+class BackgroundTensorWriter {
+public:
+    // num_threads == 0 writes synchronously inside submit()
+    explicit BackgroundTensorWriter(size_t num_threads);
+    ~BackgroundTensorWriter();
+
+    future<bool> submit(const vector<int>& shape, shared_ptr<const tsTensorData> data, const string& filename, const string& tfmt);
+
+    size_t num_threads() const { return workers_.size(); }
+
+private:
+    typedef struct WriteJob {
+        vector<int> shape;
+        shared_ptr<const tsTensorData> data;
+        string filename;
+        string tfmt;
+        promise<bool> done;
+    } WriteJob;
+
+    void worker_loop();
+
+    mutex mtx_;
+    condition_variable cv_;
+    deque<WriteJob> queue_;
+    vector<thread> workers_;
+    bool stopping_ = false;
+};
+
+// Writer used by generate_random_tensor_data (one background thread unless reconfigured)
+BackgroundTensorWriter& tensor_writer();
+
+// Replace the shared writer; call before any job runs (0 threads = synchronous writes)
+void configure_tensor_writer(size_t num_threads);
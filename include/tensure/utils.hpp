@@ -85,6 +85,14 @@ string join(const vector<int>& idxs, const string delimitter=",");
 string join(const vector<string>& idxs, const string delimitter=",");
 string join(const set<char>& chars, const string delimitter=",");
 
+/**
+ * Utility: split a string by a delimiter, dropping empty tokens
+ * @param s string to split
+ * @param delimiter character separating the tokens
+ * @return vector of non-empty tokens
+ */
+vector<string> split(const string &s, char delimiter);
+
 /**
  * Utility: ensure a directory exist, if not create one
  * @param path directory to check
@@ -98,9 +106,10 @@ void ensure_directory_exists(const std::string& path);
  * @param computations a vector of computational tensor expressions in the kernel.
  * @param dataFileNames a vector of names of the data file names for each tensors (should be as same size as tensors).
  * @param file_name file name to store the kernel as JSON.
+ * @param kernel if given, receives the kernel that was written
  * @return bool true of the kernel file has been successfully created, false otherwise.
  */
-bool generate_ref_kernel(const vector<tsTensor>& tensors, const vector<string>& computations, const vector<string>& dataFileNames, string file_name);
+bool generate_ref_kernel(const vector<tsTensor>& tensors, const vector<string>& computations, const vector<string>& dataFileNames, string file_name, tsKernel* kernel = nullptr);
 
 /**
  * Utility: Compare two tensor output files for equality within a tolerance
@@ -1,37 +1,119 @@
 #include "backends/backend_interface.hpp"
 
-using CreateFn = FuzzBackend*();
-using DestroyFn = void(FuzzBackend*);
+string to_string(InstancePolicy policy) {
+    switch (policy) {
+        case InstancePolicy::AUTO:       return "auto";
+        case InstancePolicy::SHARED:     return "shared";
+        case InstancePolicy::PER_THREAD: return "per-thread";
+        case InstancePolicy::POOL:       return "pool";
+    }
+    return "unknown";
+}
+
+InstancePolicy parseInstancePolicy(const string& s) {
+    if (s == "auto")       return InstancePolicy::AUTO;
+    if (s == "shared")     return InstancePolicy::SHARED;
+    if (s == "per-thread") return InstancePolicy::PER_THREAD;
+    if (s == "pool")       return InstancePolicy::POOL;
+    throw runtime_error("Unknown instance policy: " + s);
+}
+
+PluginHandle load_plugin(const string& so_path) {
+    PluginHandle ph{};
+    ph.path = so_path;
+    ph.dl = dlopen(so_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!ph.dl) {
+        throw runtime_error(string("dlopen failed: ") + dlerror());
+    }
+
+    ph.create_fn = (create_backend_fn)dlsym(ph.dl, "create_backend");
+    ph.destroy_fn = (destroy_backend_fn)dlsym(ph.dl, "destroy_backend");
+
+    if (!ph.create_fn) {
+        dlclose(ph.dl);
+        throw runtime_error("create_backend symbol not found in " + so_path);
+    }
+    if (!ph.destroy_fn) {
+        dlclose(ph.dl);
+        throw runtime_error("destroy_backend symbol not found in " + so_path);
+    }
 
-struct BackendHandle {
-    void* handle;
-    DestroyFn* destroy;
-};
+    // Optional: plugins that do not declare thread-safety are assumed to keep per-instance state
+    auto thread_safe_fn = (backend_thread_safe_fn)dlsym(ph.dl, "backend_thread_safe");
+    ph.thread_safe = thread_safe_fn ? thread_safe_fn() : false;
+    auto schedules_fn = (backend_supports_schedules_fn)dlsym(ph.dl, "backend_supports_schedules");
+    ph.supports_schedules = schedules_fn ? schedules_fn() : false;
 
-static BackendHandle g_backend_handle;
+    return ph;
+}
+
+void unload_plugin(PluginHandle& ph) {
+    if (!ph.dl) return;
+    dlclose(ph.dl);
+    ph = {};
+}
 
-FuzzBackend* load_backend(const std::string& so_path) {
-    void* handle = dlopen(so_path.c_str(), RTLD_NOW);
-    if (!handle) {
-        std::cerr << "dlopen failed: " << dlerror() << std::endl;
-        return nullptr;
+BackendInstances::BackendInstances(const PluginHandle& plugin, InstancePolicy policy, size_t max_instances)
+    : plugin_(plugin), policy_(policy), max_instances_(max_instances == 0 ? 1 : max_instances)
+{
+    if (policy_ == InstancePolicy::AUTO)
+        policy_ = plugin_.thread_safe ? InstancePolicy::SHARED : InstancePolicy::PER_THREAD;
+
+    if (policy_ == InstancePolicy::SHARED) {
+        if (!plugin_.thread_safe)
+            cerr << "Warning: sharing one instance of " << plugin_.path << " across threads, but the plugin does not declare itself thread-safe\n";
+        free_.push_back(create());
     }
+}
 
-    auto create_fn = (CreateFn*)dlsym(handle, "create_backend");
-    g_backend_handle.destroy = (DestroyFn*)dlsym(handle, "destroy_backend");
+BackendInstances::~BackendInstances() {
+    for (FuzzBackend* inst : all_)
+        plugin_.destroy_fn(inst);
+}
+
+FuzzBackend* BackendInstances::create() {
+    FuzzBackend* inst = plugin_.create_fn();
+    if (!inst)
+        throw runtime_error("create_backend returned null in " + plugin_.path);
+    all_.push_back(inst);
+    return inst;
+}
 
-    if (!create_fn || !g_backend_handle.destroy) {
-        std::cerr << "Missing backend symbols in " << so_path << std::endl;
-        dlclose(handle);
-        return nullptr;
+BackendInstances::Lease BackendInstances::acquire() {
+    unique_lock<mutex> lock(mtx_);
+    switch (policy_) {
+        case InstancePolicy::PER_THREAD: {
+            auto it = per_thread_.find(this_thread::get_id());
+            if (it != per_thread_.end())
+                return Lease(this, it->second);
+            FuzzBackend* inst = create();
+            per_thread_.emplace(this_thread::get_id(), inst);
+            return Lease(this, inst);
+        }
+        case InstancePolicy::POOL: {
+            cv_.wait(lock, [this] { return !free_.empty() || all_.size() < max_instances_; });
+            if (free_.empty())
+                return Lease(this, create());
+            FuzzBackend* inst = free_.back();
+            free_.pop_back();
+            return Lease(this, inst);
+        }
+        case InstancePolicy::SHARED:
+        default:
+            return Lease(this, free_.front());
     }
+}
 
-    g_backend_handle.handle = handle;
-    return create_fn();
+void BackendInstances::release(FuzzBackend* inst) {
+    if (policy_ != InstancePolicy::POOL) return;
+    {
+        lock_guard<mutex> lock(mtx_);
+        free_.push_back(inst);
+    }
+    cv_.notify_one();
 }
 
-void unload_backend(FuzzBackend* backend) {
-    if (g_backend_handle.destroy) g_backend_handle.destroy(backend);
-    if (g_backend_handle.handle) dlclose(g_backend_handle.handle);
-    g_backend_handle = {};
+size_t BackendInstances::instance_count() {
+    lock_guard<mutex> lock(mtx_);
+    return all_.size();
 }
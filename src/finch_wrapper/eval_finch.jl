@@ -1,5 +1,6 @@
 import LazyJSON as JSON
 using Finch
+using Mmap
 
 """
     compile_format(formats)
@@ -26,6 +27,90 @@ function compile_format(formats)
     return expr
 end
 
+"""
+    read_tsb(path)
+
+Reads a TenSure binary tensor file (.tsb, see include/tensure/tensor_io.hpp) into a COO Finch tensor:
+a 64-byte header, the shape, one Int32 coordinate array per mode and a Float64 value array, every
+section 64-byte aligned. Coordinates are shifted from the file's index base to Julia's 1-based indexing.
+"""
+function read_tsb(path)
+    data = Mmap.mmap(path)
+    String(data[1:8]) == "TSURETSB" || error("Not a TenSure binary tensor file: $path")
+    rank = Int(reinterpret(UInt32, data[13:16])[1])
+    nnz = Int(reinterpret(UInt64, data[17:24])[1])
+    index_base = Int(reinterpret(UInt32, data[25:28])[1])
+    align(bytes) = cld(bytes, 64) * 64
+
+    offset = 64
+    shape = Tuple(Int.(reinterpret(Int64, data[offset+1:offset+8*rank])))
+    offset += align(8 * rank)
+    coords = map(1:rank) do _
+        c = Int.(reinterpret(Int32, data[offset+1:offset+4*nnz])) .+ (1 - index_base)
+        offset += align(4 * nnz)
+        c
+    end
+    values = collect(reinterpret(Float64, data[offset+1:offset+8*nnz]))
+    return fsparse(coords..., values, shape)
+end
+
+read_input(path) = endswith(path, ".tsb") ? read_tsb(path) : fread(path)
+
+# FINGERPRINT_GRID in include/tensure/comparator.hpp
+const FINGERPRINT_GRID = 1e-9
+
+function mix64(x::UInt64)
+    x ⊻= x >> 33
+    x *= 0xff51afd7ed558ccd
+    x ⊻= x >> 33
+    x *= 0xc4ceb9fe1a85ec53
+    return x ⊻ (x >> 33)
+end
+
+function entry_hash(coords, steps)
+    h = 0x9E3779B97F4A7C15
+    for c in coords
+        h = mix64(h ⊻ c)
+    end
+    return mix64(h ⊻ reinterpret(UInt64, round(Int64, steps, RoundNearestTiesAway)))
+end
+
+# FINGERPRINT_TEST_HASH in include/tensure/comparator.hpp; a drifted hash would never match TenSure's
+const FINGERPRINT_HASH_OK = entry_hash(UInt64[0, 1], 1.5 / FINGERPRINT_GRID) +
+                            entry_hash(UInt64[2, 3], -0.25 / FINGERPRINT_GRID) == 0xE5488BFCFA603D28
+
+"""
+    write_fingerprint(path, tensor)
+
+Writes the fingerprint of a result next to it, as OutputFingerprint in include/tensure/comparator.hpp
+(same hash, same line layout): every nonzero hashes its 1-based coordinates and its value rounded to
+FINGERPRINT_GRID, and the hashes are summed. Nothing is written if a value cannot be rounded (Inf, NaN)
+or the hash disagrees with the shared test vector; TenSure then compares the result files themselves.
+"""
+function write_fingerprint(path, tensor)
+    FINGERPRINT_HASH_OK || return
+    nz = ffindnz(tensor)
+    coords, values = nz[1:end-1], nz[end]
+    coord_sums = zeros(UInt64, length(coords))
+    c = zeros(UInt64, length(coords))
+    nnz = UInt64(0)
+    value_hash = UInt64(0)
+    for n in eachindex(values)
+        values[n] == 0.0 && continue
+        steps = values[n] / FINGERPRINT_GRID
+        abs(steps) < 9.0e18 || return
+        for d in eachindex(coords)
+            c[d] = reinterpret(UInt64, Int64(coords[d][n]))
+            coord_sums[d] += c[d]
+        end
+        value_hash += entry_hash(c, steps)
+        nnz += 1
+    end
+    open(path, "w") do io
+        println(io, join(["TSFP1", repr(FINGERPRINT_GRID), length(coords), nnz, value_hash, coord_sums...], " "))
+    end
+end
+
 """
 emit_einsum_block(name, spec)
 Generates a Julia expression block for a single einsum operation defined in the JSON spec.
@@ -53,8 +138,8 @@ function emit_einsum_block(name, spec)
 
         fmt_expr = compile_format(formats)
 
-        # Generate: B = Tensor(Dense(SparseList(...)), fread("path"))
-        push!(input_defs, :($var_name = Tensor($fmt_expr, fread($file_path))))
+        # Generate: B = Tensor(Dense(SparseList(...)), read_input("path"))
+        push!(input_defs, :($var_name = Tensor($fmt_expr, read_input($file_path))))
 
         # Prepare access term: B[i, k]
         indices = input_indices_list[i]
@@ -81,11 +166,24 @@ function emit_einsum_block(name, spec)
 
     write_expr = :(fwrite($out_file, $out_name))
 
+    # A missing fingerprint only costs the full comparison, so it never fails the kernel
+    fingerprint_file = splitext(out_file)[1] * ".fp"
+    fingerprint_expr = :(try
+        write_fingerprint($fingerprint_file, $out_name)
+    catch
+    end)
+
+    # Report the computation time next to the result, in the same form as the TACO backend
+    time_file = splitext(out_file)[1] * ".txt"
+    time_expr = :(write($time_file, "Computation time: " * string(compute_elapsed_ms) * " ms\n"))
+
     return quote
         $(input_defs...)
         $out_def
-        $kernel_expr
+        compute_elapsed_ms = 1000 * @elapsed $kernel_expr
         $write_expr
+        $fingerprint_expr
+        $time_expr
     end
 end
 
@@ -63,6 +63,12 @@ int FinchBackend::execute_kernel(const fs::path &kernelPath,
           fs::create_directories(ref_out_dir);
           fs::copy_file(src_file, dst_file,
                         fs::copy_options::overwrite_existing);
+
+          // The fingerprint travels with the result
+          fs::path src_fp = fingerprint_file(src_file.string());
+          if (fs::exists(src_fp))
+            fs::copy_file(src_fp, fingerprint_file(dst_file.string()),
+                          fs::copy_options::overwrite_existing);
         }
       } catch (const std::exception &e) {
         std::cerr << "Warning: Failed to copy reference output: " << e.what()
@@ -74,37 +80,48 @@ int FinchBackend::execute_kernel(const fs::path &kernelPath,
   return ret;
 }
 
-bool FinchBackend::compare_results(const string &ref, const string &test) {
-  // The core fuzzer passes full file paths (usually defaulting to .tns).
-  // Since we switched to .ttx, we need to handle the mismatch if the file
-  // passed doesn't exist but the .ttx version does.
-
-  fs::path pRef(ref);
-  fs::path pTest(test);
-
-  auto resolve_path = [](fs::path p) -> fs::path {
-    // If the path exists, use it.
-    if (fs::exists(p))
-      return p;
-
-    // If it's a .tns file that doesn't exist, try .ttx
-    if (p.extension() == ".tns") {
-      fs::path ttx_path = p;
-      ttx_path.replace_extension(".ttx");
-      if (fs::exists(ttx_path))
-        return ttx_path;
-    }
+namespace {
+
+// The core fuzzer passes full file paths (usually defaulting to .tns).
+// Since we switched to .ttx, we need to handle the mismatch if the file
+// passed doesn't exist but the .ttx version does.
+fs::path resolve_results_path(fs::path p) {
+  // If the path exists, use it.
+  if (fs::exists(p))
     return p;
-  };
 
-  pRef = resolve_path(pRef);
-  pTest = resolve_path(pTest);
+  // If it's a .tns file that doesn't exist, try .ttx
+  if (p.extension() == ".tns") {
+    fs::path ttx_path = p;
+    ttx_path.replace_extension(".ttx");
+    if (fs::exists(ttx_path))
+      return ttx_path;
+  }
+  return p;
+}
+
+// Absolute tolerance between a mutant's results and the reference
+const double FINCH_TOLERANCE = 1e-5;
+
+} // namespace
+
+bool FinchBackend::compare_results(const string &ref, const string &test) {
+  fs::path pRef = resolve_results_path(ref);
+  fs::path pTest = resolve_results_path(test);
 
   // Use the global compare_outputs from tensure/utils.hpp with a tolerance
-  return ::compare_outputs(pRef.string(), pTest.string(), 1e-5);
+  return ::compare_outputs(pRef.string(), pTest.string(), FINCH_TOLERANCE);
+}
+
+bool FinchBackend::compare_results(const ReferenceOutput &ref,
+                                   const string &test) {
+  return ref.matches(resolve_results_path(test).string(), FINCH_TOLERANCE);
 }
 
 // Plugin entry points required by TenSure's backend loader
 extern "C" FuzzBackend *create_backend() { return new FinchBackend(); }
 
 extern "C" void destroy_backend(FuzzBackend *backend) { delete backend; }
+
+// Kernels run in a separate julia process per call; the backend holds no state
+extern "C" bool backend_thread_safe() { return true; }
@@ -1,6 +1,8 @@
 // src/main.cpp
 #include <nlohmann/json.hpp>
 #include <signal.h>
+#include <unistd.h>
+#include <sys/statvfs.h>
 #include <thread>
 #include <chrono>
 #include <filesystem>
@@ -11,9 +13,16 @@
 #include <memory>
 #include <dlfcn.h>
 #include <future>
+#include <unordered_set>
+#include <regex>
 
 #include "tensure/logger.hpp"
 #include "tensure/random_gen.hpp"                // your generator helpers (tsTensor, etc.)
+#include "tensure/dataset.hpp"
+#include "tensure/tensor_io.hpp"
+#include "tensure/profile.hpp"
+#include "tensure/reference_eval.hpp"
+#include "tensure/op_scheduler.hpp"
 #include "backends/backend_interface.hpp"       // FuzzBackend interface
 #include "tensure/ThreadPool.hpp"
 
@@ -33,6 +42,10 @@ std::atomic<size_t> g_ref_crash_count = 0;
 std::atomic<size_t> g_crash_bug_count = 0;
 std::atomic<size_t> g_wrong_code_count = 0;
 std::atomic<size_t> g_valid_einsum_count = 0;
+std::atomic<size_t> g_cross_backend_count = 0;
+
+// Generation profile of the campaign, stored with every archived failure
+static json g_profile_json;
 
 // timestamp helper (kept from your original)
 std::string timestamp_str() {
@@ -60,6 +73,10 @@ int run_with_timeout(FuzzBackend* backend, const std::string& kernel_path, const
     if (fut.wait_for(std::chrono::milliseconds(timeout_ms)) == std::future_status::ready) {
         try {
             return fut.get();  // Get result if finished
+        } catch (const std::bad_alloc&) {
+            // Out of memory running the kernel's harness: not a bug of the kernel
+            LOG_WARN("Out of memory in timed task, skipping it");
+            return BACKEND_SKIPPED;
         } catch (const std::exception& e) {
             std::cerr << "Exception from timed task: " << e.what() << std::endl;
             LOG_ERROR((std::ostringstream{} << "Exception from timed task: " << e.what()).str());
@@ -73,47 +90,6 @@ int run_with_timeout(FuzzBackend* backend, const std::string& kernel_path, const
     }
 }
 
-// ---------- backend plugin loader ----------
-struct PluginHandle {
-    void* dl = nullptr;
-    FuzzBackend* inst = nullptr;
-    void (*destroy_fn)(FuzzBackend*) = nullptr;
-};
-
-PluginHandle load_plugin(const string &so_path) {
-    PluginHandle ph{};
-    ph.dl = dlopen(so_path.c_str(), RTLD_NOW | RTLD_LOCAL);
-    if (!ph.dl) {
-        throw runtime_error(string("dlopen failed: ") + dlerror());
-    }
-
-    using create_fn_t = FuzzBackend* (*)();
-    using destroy_fn_t = void (*)(FuzzBackend*);
-
-    auto create_fn = (create_fn_t)dlsym(ph.dl, "create_backend");
-    auto destroy_fn = (destroy_fn_t)dlsym(ph.dl, "destroy_backend");
-
-    if (!create_fn) {
-        dlclose(ph.dl);
-        throw runtime_error("create_backend symbol not found in " + so_path);
-    }
-    if (!destroy_fn) {
-        dlclose(ph.dl);
-        throw runtime_error("destroy_backend symbol not found in " + so_path);
-    }
-
-    ph.inst = create_fn();
-    ph.destroy_fn = destroy_fn;
-    return ph;
-}
-
-void unload_plugin(PluginHandle &ph) {
-    if (!ph.dl) return;
-    if (ph.destroy_fn && ph.inst) ph.destroy_fn(ph.inst);
-    dlclose(ph.dl);
-    ph = {};
-}
-
 // ---------- helper: archive failure case (best-effort copy) ----------
 static void copy_tree(const fs::path& src, const fs::path& dst) {
     for (auto& entry : fs::recursive_directory_iterator(src)) {
@@ -135,11 +111,43 @@ static void append_log(const fs::path& file, const std::string& reason) {
     out << reason << "\n";
 }
 
-void archive_failure_case(const fs::path &dir_name, const fs::path &kernel_dir, const fs::path &fail_dir, const string &reason) {
+// Point the kernel specifications and programs of an archived case at its own copies of the data and kernels.
+// Needed when the corpus lives in memory (--shm) and disappears with the iteration.
+static void relocate_paths(const fs::path& case_dir, const fs::path& old_dir, const fs::path& new_dir) {
+    string from = old_dir.string();
+    string to = (old_dir.is_absolute() ? fs::absolute(new_dir) : new_dir).string();
+    for (auto& entry : fs::recursive_directory_iterator(case_dir)) {
+        string ext = entry.path().extension().string();
+        if (!entry.is_regular_file() || (ext != ".json" && ext != ".cpp" && ext != ".jl" && ext != ".mlir")) continue;
+
+        std::ifstream in(entry.path());
+        string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        bool changed = false;
+        for (size_t pos = text.find(from); pos != string::npos; pos = text.find(from, pos)) {
+            // Only whole path components: .../kernel must not rewrite .../kernel1
+            char next = pos + from.size() < text.size() ? text[pos + from.size()] : '/';
+            if (isalnum((unsigned char)next) || next == '_') {
+                pos += from.size();
+                continue;
+            }
+            text.replace(pos, from.size(), to);
+            pos += to.size();
+            changed = true;
+        }
+        if (changed) std::ofstream(entry.path(), std::ios::trunc) << text;
+    }
+}
+
+// Kernel specifications are held in memory; the archived case gets the JSON of `spec` (as <kernel-name>.json)
+// and of the reference `ref_spec` (as kernel.json)
+void archive_failure_case(const fs::path &dir_name, const fs::path &kernel_dir, const fs::path &fail_dir, const string &reason, const tsKernel* spec = nullptr, const tsKernel* ref_spec = nullptr) {
      try {
         fs::create_directories(fail_dir);
         fs::path case_failure_dir = fail_dir / dir_name;
         fs::create_directories(case_failure_dir);
+        if (spec) spec->saveJson((case_failure_dir / (kernel_dir.stem().string() + ".json")).string());
+        if (ref_spec) ref_spec->saveJson((case_failure_dir / "kernel.json").string());
 
         // 1. Copy the kernel_dir -> case_failure_dir/<kernel-name>
         copy_tree(kernel_dir, case_failure_dir / kernel_dir.stem());
@@ -153,25 +161,425 @@ void archive_failure_case(const fs::path &dir_name, const fs::path &kernel_dir,
         // 3. Copy shared data directory
         fs::path data_dir = kernel_dir.parent_path().parent_path() / "data";
         copy_tree(data_dir, case_failure_dir / "data");
+        relocate_paths(case_failure_dir, data_dir, case_failure_dir / "data");
+        relocate_paths(case_failure_dir, kernel_dir, case_failure_dir / kernel_dir.stem());
+        if (kernel_dir.stem().string() != "kernel")
+            relocate_paths(case_failure_dir, kernel_dir.parent_path() / "kernel", case_failure_dir / "kernel");
 
-        // write reason log
+        // write reason log; the iteration number is part of dir_name
         append_log(case_failure_dir / "failure.log", reason);
+        append_log(case_failure_dir / "failure.log", "FUZZ_SEED=" + to_string(campaign_seed()));
+        std::ofstream(case_failure_dir / "profile.json") << g_profile_json.dump(4) << "\n";
 
     } catch (const std::exception &e) {
         std::cerr << "archive_failure_case() failed: " << e.what() << "\n";
     }
 }
 
+// ---------- loaded target backends ----------
+struct TargetBackend {
+    string tag;                              // short name used for directories and logs
+    PluginHandle plugin;
+    unique_ptr<BackendInstances> instances;
+};
+
+// Derive a directory-friendly tag from the plugin path (e.g. ./libtaco_wrapper.so -> taco_wrapper)
+static string backend_tag(const string& so_path) {
+    string tag = fs::path(so_path).stem().string();
+    if (tag.rfind("lib", 0) == 0) tag = tag.substr(3);
+    return tag.empty() ? "backend" : tag;
+}
+
+// ---------- campaign-wide settings shared by all jobs ----------
+struct CampaignConfig {
+    fs::path out_root;
+    string tensor_file_format;
+    uint64_t executor_timeout_ms;
+    double cross_backend_tol;               // tolerance for comparing outputs of different backends
+    string sparsity_pattern;                // input data pattern, or "random" per tensor
+    DatasetCatalog* datasets;               // real-world inputs (--dataset), nullptr if not used
+    double dataset_prob;                    // probability that a job builds its kernel around a dataset tensor
+    fs::path work_root;                     // holds corpus/: out_root, or a tmpfs directory with --shm
+    bool transient_corpus;                  // corpus is in memory; iterations never outlive their job
+    TensorDataPool* data_pool;              // generated inputs shared across iterations (--data-pool-mb), nullptr if off
+    CampaignProfile profile;                // kernel and data generation parameters (--profile)
+    SampleOptions sampling;                 // sampled comparison of large outputs (--sample-compare), min_nnz 0 if off
+    double sample_full_prob;                // fraction of sampling iterations still compared in full
+    bool native_ref;                        // evaluate the reference in-process instead of on the backend (--native-ref)
+    size_t native_ref_threads;              // threads of each sparse contraction of the in-process reference
+    int max_mutants;                        // mutants per kernel, fewer when its mutation space is smaller
+    OperatorScheduler* op_scheduler;        // picks the mutation operator of each mutant (--op-scheduler)
+};
+
+// ---------- per-kernel timing log ----------
+static std::mutex g_timing_mutex;
+
+// Backends may report numbers in <kernel_dir>/results.txt as "<key> X", e.g. "Computation time: X ms".
+// Returns -1 if nothing was reported.
+static double read_reported_value(const fs::path& kernel_dir, const string& key) {
+    std::ifstream in(kernel_dir / "results.txt");
+    string line;
+    while (std::getline(in, line)) {
+        size_t pos = line.find(key);
+        if (pos == string::npos) continue;
+        try {
+            return std::stod(line.substr(pos + key.size()));
+        } catch (...) {
+            return -1.0;
+        }
+    }
+    return -1.0;
+}
+
+static double read_reported_compute_ms(const fs::path& kernel_dir) {
+    return read_reported_value(kernel_dir, "Computation time:");
+}
+
+static void record_timing(const fs::path& timing_file, const string& iter_id, const string& backend, const string& kernel, int result, double wall_ms, double compute_ms) {
+    std::lock_guard<std::mutex> lock(g_timing_mutex);
+    bool write_header = !fs::exists(timing_file);
+    std::ofstream out(timing_file, std::ios::app);
+    if (write_header)
+        out << "iteration,backend,kernel,exit_code,wall_ms,compute_ms\n";
+    out << iter_id << "," << backend << "," << kernel << "," << result << "," << wall_ms << "," << compute_ms << "\n";
+}
+
+// Run one kernel with the timeout guard and record its timing (also returned in wall_ms and compute_ms if given)
+static int run_timed(FuzzBackend* backend, const TargetBackend& target, const fs::path& kernel_path, uint64_t timeout_ms, const fs::path& timing_file, const string& iter_id, double* wall_ms = nullptr, double* compute_ms_out = nullptr) {
+    auto start = std::chrono::steady_clock::now();
+    int result = run_with_timeout(backend, kernel_path.string(), "", timeout_ms);
+    std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - start;
+
+    fs::path kernel_dir = kernel_path.parent_path();
+    double compute_ms = (result == 0) ? read_reported_compute_ms(kernel_dir) : -1.0;
+    record_timing(timing_file, iter_id, target.tag, kernel_dir.stem().string(), result, wall.count(), compute_ms);
+    if (wall_ms) *wall_ms = wall.count();
+    if (compute_ms_out) *compute_ms_out = compute_ms;
+    return result;
+}
+
 /**
- * @brief The core fuzzing task executed by a single worker thread.
+ * @brief Append a scheduled mutant's result and its speedup over the same kernel without the schedule.
+ * baseline is the unscheduled kernel (the reference or an earlier mutant); times are -1 when not reported.
+ */
+static void record_schedule(const fs::path& schedule_file, const string& iter_id, const string& backend, const string& kernel, const string& baseline, const string& schedule, const string& result, double rejected, double compute_ms, double baseline_ms) {
+    std::lock_guard<std::mutex> lock(g_timing_mutex);
+    bool write_header = !fs::exists(schedule_file);
+    std::ofstream out(schedule_file, std::ios::app);
+    if (write_header)
+        out << "iteration,backend,kernel,baseline,schedule,result,rejected_commands,compute_ms,baseline_compute_ms,speedup\n";
+    out << iter_id << "," << backend << "," << kernel << "," << baseline << ",\"" << schedule << "\"," << result << "," << rejected << "," << compute_ms << "," << baseline_ms << ",";
+    if (compute_ms > 0 && baseline_ms > 0)
+        out << baseline_ms / compute_ms;
+    out << "\n";
+}
+
+// ---------- emitted code seen so far, for the operator scheduler's novelty reward ----------
+static std::mutex g_code_mutex;
+static unordered_set<size_t> g_code_hashes;
+
+// A mutant that still times out after this many longer retries is skipped
+static const int MAX_TIMEOUT_RETRIES = 3;
+
+// A mutant below this wall time is never a performance outlier, however fast its siblings ran
+static const double OUTLIER_MIN_MS = 100.0;
+static const double OUTLIER_FACTOR = 10.0;
+
+// Fingerprint misses without a single hit that point at drifted fingerprint hashes
+static const uint64_t MIN_FINGERPRINT_MISSES = 20;
+
+/**
+ * @brief Hash the code a backend emitted into a kernel directory and remember it.
+ * Backends that interpret the kernel specification (Finch) emit only its JSON, which then counts as the code.
+ * Paths and numbers (dimensions, file names) are blanked out, so only the shape of the code counts.
+ * @return true if no earlier kernel of this backend emitted the same code
  */
-void FuzzingJob(size_t iter, FuzzBackend* target_backend, std::mt19937::result_type seed_offset, fs::path& out_root, const std::string& tensor_file_format, const uint64_t executor_timeout_ms
-    ) {
-    // Create a thread-local RNG based on the global seed offset
-    std::mt19937 local_rng(seed_offset + iter);
+static bool record_emitted_code(const string& tag, const fs::path& kernel_dir, const fs::path& iter_dir) {
+    static const std::regex numbers("[0-9]+");
+    vector<fs::path> files;
+    if (!fs::is_directory(kernel_dir)) return false;
+    for (auto& entry : fs::directory_iterator(kernel_dir)) {
+        string ext = entry.path().extension().string();
+        if (entry.is_regular_file() && (ext == ".cpp" || ext == ".c" || ext == ".h" || ext == ".jl" || ext == ".mlir" || ext == ".ll" || ext == ".json"))
+            files.push_back(entry.path());
+    }
+    if (files.empty()) return false;
+    sort(files.begin(), files.end());
+
+    string code = tag;
+    for (const auto& file : files) {
+        std::ifstream in(file);
+        string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        for (const string& dir : {kernel_dir.string(), iter_dir.string()}) {
+            for (size_t pos = text.find(dir); !dir.empty() && pos != string::npos; pos = text.find(dir, pos))
+                text.replace(pos, dir.size(), "");
+        }
+        code += "\n" + file.filename().string() + "\n" + std::regex_replace(text, numbers, "#");
+    }
+
+    std::lock_guard<std::mutex> lock(g_code_mutex);
+    return g_code_hashes.insert(std::hash<string>{}(code)).second;
+}
+
+// Backends differ in the extension of the result file they emit
+static fs::path find_results_file(const fs::path& kernel_dir) {
+    for (const char* ext : {".tns", ".ttx", ".mtx", ".tsb"}) {
+        fs::path candidate = kernel_dir / (string("results") + ext);
+        if (fs::exists(candidate)) return candidate;
+    }
+    return {};
+}
+
+/**
+ * @brief Generate, run and compare all kernels of one iteration on a single backend.
+ * @param native_ref output of the in-process reference; when set the backend's reference kernel is not run
+ * @param mutation_ops operator each kernel was derived with; backends without schedule support skip SCHEDULE mutants
+ * @param outcomes one per kernel; what each mutant run on this backend produced is added to it
+ * @return path to the backend's reference kernel directory, empty if the reference did not run
+ */
+static fs::path run_backend_iteration(TargetBackend& target, bool multi_backend, const vector<tsKernel>& kernels, const vector<MutationOperator>& mutation_ops, const vector<string>& kernel_files, bool dense_output, const SampleOptions* sampling, uint64_t sample_seed, const fs::path& native_ref, vector<MutantOutcome>& outcomes, const fs::path& iter_dir, const string& iter_id, const CampaignConfig& cfg) {
+    // Lease a backend instance for the whole job; non-reentrant plugins never see two threads at once
+    BackendInstances::Lease target_lease = target.instances->acquire();
+    FuzzBackend* target_backend = target_lease.get();
+
+    fs::path fail_dir = cfg.out_root / "failures";
+    fs::path iter_data_dir = iter_dir / "data";
+    fs::path timing_file = cfg.out_root / "timings.csv";
+    // With several backends each one keeps its own kernels and its own archive sub-directory
+    fs::path case_name = multi_backend ? fs::path(iter_id) / target.tag : fs::path(iter_id);
+
+    // Generate the backend specific kernel
+    fs::path backend_kernel = iter_dir / (multi_backend ? "backend_kernel_" + target.tag : string("backend_kernel"));
+    fs::create_directories(backend_kernel);
+    bool gen_ok = target_backend->generate_kernel(kernels, kernel_files, backend_kernel);
+    if (!gen_ok) {
+        cerr << "generate_kernel failed for iter " << iter_id << "\n";
+        LOG_WARN("generate_kernel failed for iter " + iter_id + " to generate mutated backend kernels (" + target.tag + ").");
+        return {};
+    }
+
+    // Run reference executor (trusted) once to produce expected outputs
+    uint64_t timeout = cfg.executor_timeout_ms; // Use CLI-defined timeout
+    fs::path ref_out_dir = iter_data_dir / "ref_out";
+    // Start empty: results are looked up by extension, and a previous backend's output must not be picked up
+    fs::remove_all(ref_out_dir);
+    fs::create_directories(ref_out_dir);
+    
+    // Use the generated reference kernel path
+    // TODO: Make it generic
+    fs::path ref_kernel_filename = backend_kernel / "kernel/backend_kernel.cpp";
+
+    // The in-process reference already holds the expected output
+    double ref_wall_ms = -1.0, ref_compute_ms = -1.0;
+    int ref_result = native_ref.empty() ? run_timed(target_backend, target, ref_kernel_filename, timeout, timing_file, iter_id, &ref_wall_ms, &ref_compute_ms) : 0;
+
+    if (ref_result == BACKEND_SKIPPED) {
+        LOG_WARN("Reference kernel of " + iter_id + " (" + target.tag + ") could not be run by the backend harness, skipping the iteration");
+        return {};
+    }
+    if (ref_result != 0) {
+        g_ref_crash_count++;
+        std::string message;
+        if (ref_result == -2) message = "Reference Kernel execution timed out";
+        else message = "Reference Kernel execution failed with code " + to_string(ref_result);
+        
+        LOG_INFO(message + ": " + iter_id + " (" + target.tag + ")");
+        archive_failure_case(case_name, ref_kernel_filename.parent_path(), fail_dir / "ref_crash", message, &kernels[0]);
+        return {}; 
+    }
+
+    // Run target on each mutant and compare outputs
+    LOG_INFO("Running mutants on " + target.tag + "...");
     
-    // The distributed is kept local to ensure each thread uses fresh randomness
-    std::uniform_int_distribution<int> dist_tensor_count(2, 5);
+    // Parsed on the first comparison and shared by all the mutants
+    unique_ptr<ReferenceOutput> ref_output;
+    // Wall times of the kernels that ran to completion, the reference's included, for the outlier check
+    vector<double> wall_ms(kernels.size(), -1.0);
+    wall_ms[0] = ref_wall_ms;
+    // Correctness and computation time of each kernel that ran, for the schedule log
+    vector<string> verdict(kernels.size());
+    vector<double> compute_ms(kernels.size(), -1.0);
+    compute_ms[0] = ref_compute_ms;
+
+    int timeout_retries = 0;
+    for (size_t mi = 1; mi < kernels.size() && !g_terminate; ++mi) {
+        // A backend that ignores schedules would only rerun the kernel the schedule was added to
+        if (mutation_ops[mi] == MutationOperator::SCHEDULE && !target.plugin.supports_schedules) continue;
+        fs::path mutant_path = backend_kernel / ("kernel" + to_string(mi)) / "backend_kernel.cpp";
+        
+        // Run target backend on the mutated kernel
+        double mutant_ms = 0.0;
+        int result = run_timed(target_backend, target, mutant_path, timeout, timing_file, iter_id, &mutant_ms, &compute_ms[mi]);
+        outcomes[mi].wall_seconds += mutant_ms / 1000.0;
+        if (result != -2) timeout_retries = 0;
+        if (result != -2 && record_emitted_code(target.tag, mutant_path.parent_path(), iter_dir))
+            outcomes[mi].new_code = true;
+        
+        if (result == BACKEND_SKIPPED) {
+            LOG_WARN("Mutant " + to_string(mi) + " of " + iter_id + " (" + target.tag + ") could not be run by the backend harness, skipping it");
+            continue;
+        }
+        if (result != 0) {
+            // Crashing bug or timeout
+            if (result == -2) {
+                // Timeout: Increase timeout and retry this mutant, a few times at most
+                if (++timeout_retries <= MAX_TIMEOUT_RETRIES) {
+                    timeout += 4000;
+                    mi--; // Decrement to retry the current mutant
+                    continue;
+                }
+                LOG_WARN("Mutant " + to_string(mi) + " of " + iter_id + " (" + target.tag + ") timed out " + to_string(timeout_retries) + " times, skipping it");
+                timeout_retries = 0;
+                continue;
+            }
+            // Actual Crashing Bug
+            g_crash_bug_count++;
+            outcomes[mi].bug = true;
+            verdict[mi] = "crash";
+            LOG_INFO("CRASHING BUG FOUND IN MUTANT " + to_string(mi) + " of " + iter_id + " (" + target.tag + ")");
+            archive_failure_case(case_name, mutant_path.parent_path(), fail_dir / "crash", "Mutated Kernel execution failed with code " + to_string(result), &kernels[mi], &kernels[0]);
+            break; // don't break, if you want to check whether other mutants also induce bugs
+        } 
+        
+        // Compare the results for a wrong code bug
+        // Backends pick the result extension (text or .tsb); fall back to the historical .tns name
+        if (!ref_output && !native_ref.empty()) {
+            ref_output = make_unique<ReferenceOutput>(native_ref.string(), dense_output);
+            if (sampling) ref_output->enable_sampling(*sampling, sample_seed);
+        } else if (!ref_output) {
+            fs::path ref_out_path = find_results_file(iter_data_dir / "ref_out");
+            ref_output = make_unique<ReferenceOutput>((ref_out_path.empty() ? iter_data_dir / "ref_out" / "results.tns" : ref_out_path).string(), dense_output);
+            if (sampling) ref_output->enable_sampling(*sampling, sample_seed);
+        }
+        fs::path mutant_out_path = find_results_file(mutant_path.parent_path());
+        string mutant_out_file = (mutant_out_path.empty() ? mutant_path.parent_path() / "results.tns" : mutant_out_path).string();
+        bool equal = target_backend->compare_results(*ref_output, mutant_out_file);
+        
+        if (!equal) {
+            LOG_INFO("WRONG CODE BUG FOUND IN MUTANT " + to_string(mi) + " of " + iter_id + " (" + target.tag + ")");
+            g_wrong_code_count++;
+            outcomes[mi].bug = true;
+            verdict[mi] = "wrong_code";
+            archive_failure_case(case_name, mutant_path.parent_path(), fail_dir / "wc", "Mutated Kernel produced incorrect results.", &kernels[mi], &kernels[0]);
+            break; // don't break, if you want to check whether other mutants also induce bugs
+        }
+        wall_ms[mi] = mutant_ms;
+        verdict[mi] = "ok";
+    }
+
+    // Scheduled mutants against the kernel they were scheduled from, the only difference being the schedule
+    for (size_t mi = 1; mi < kernels.size(); ++mi) {
+        if (verdict[mi].empty() || kernels[mi].computations.empty() || kernels[mi].computations[0].schedule.empty()) continue;
+        tsKernel unscheduled = kernels[mi];
+        unscheduled.computations[0].schedule.clear();
+        uint64_t hash = kernel_hash(unscheduled);
+        size_t base = 0;
+        while (base < mi && kernel_hash(kernels[base]) != hash) base++;
+        fs::path mutant_dir = backend_kernel / ("kernel" + to_string(mi));
+        record_schedule(cfg.out_root / "schedules.csv", iter_id, target.tag, "kernel" + to_string(mi), base < mi ? (base == 0 ? string("reference") : "kernel" + to_string(base)) : string(), to_string(kernels[mi].computations[0].schedule), verdict[mi], read_reported_value(mutant_dir, "Schedule commands rejected:"), compute_ms[mi], base < mi ? compute_ms[base] : -1.0);
+    }
+
+    // Equivalent kernels should take comparable time: one far slower than the median is an outlier
+    vector<double> completed;
+    for (double ms : wall_ms)
+        if (ms >= 0) completed.push_back(ms);
+    if (completed.size() >= 3) {
+        nth_element(completed.begin(), completed.begin() + completed.size() / 2, completed.end());
+        double median = completed[completed.size() / 2];
+        for (size_t mi = 1; mi < kernels.size(); ++mi)
+            if (wall_ms[mi] >= OUTLIER_MIN_MS && wall_ms[mi] > OUTLIER_FACTOR * median)
+                outcomes[mi].outlier = true;
+    }
+
+    // Without a backend reference run there is nothing to cross-check
+    return native_ref.empty() ? ref_kernel_filename.parent_path() : fs::path();
+}
+
+/**
+ * @brief Compare the reference outputs of all backends that ran successfully against the first one.
+ */
+static void cross_check_backends(const vector<TargetBackend>& targets, const vector<fs::path>& ref_kernel_dirs, bool dense_output, const fs::path& iter_dir, const string& iter_id, const CampaignConfig& cfg) {
+    size_t base = ref_kernel_dirs.size();
+    for (size_t b = 0; b < ref_kernel_dirs.size(); ++b) {
+        if (!ref_kernel_dirs[b].empty()) { base = b; break; }
+    }
+    if (base == ref_kernel_dirs.size()) return;
+
+    fs::path base_out = find_results_file(ref_kernel_dirs[base]);
+    if (base_out.empty()) return;
+    unique_ptr<ReferenceOutput> base_ref;
+
+    for (size_t b = base + 1; b < ref_kernel_dirs.size(); ++b) {
+        if (ref_kernel_dirs[b].empty()) continue;
+
+        fs::path other_out = find_results_file(ref_kernel_dirs[b]);
+        if (!other_out.empty() && !base_ref)
+            base_ref = make_unique<ReferenceOutput>(base_out.string(), dense_output);
+        bool equal = !other_out.empty() && base_ref->matches(other_out.string(), cfg.cross_backend_tol);
+        if (equal) continue;
+
+        g_cross_backend_count++;
+        string reason = "Backends " + targets[base].tag + " and " + targets[b].tag + " disagree on the reference kernel.";
+        LOG_INFO("CROSS-BACKEND MISMATCH IN " + iter_id + ": " + reason);
+        try {
+            fs::path case_dir = cfg.out_root / "failures" / "xbackend" / iter_id;
+            for (size_t k : {base, b}) {
+                copy_tree(ref_kernel_dirs[k], case_dir / targets[k].tag / "kernel");
+            }
+            copy_tree(iter_dir / "data", case_dir / "data");
+            relocate_paths(case_dir, iter_dir / "data", case_dir / "data");
+            for (size_t k : {base, b})
+                relocate_paths(case_dir, ref_kernel_dirs[k], case_dir / targets[k].tag / "kernel");
+            append_log(case_dir / "failure.log", reason);
+            std::ofstream(case_dir / "profile.json") << g_profile_json.dump(4) << "\n";
+        } catch (const std::exception &e) {
+            std::cerr << "cross-backend archive failed: " << e.what() << "\n";
+        }
+    }
+}
+
+/**
+ * @brief Evaluate the iteration's kernel with the in-process reference and write its output.
+ * @return path to the reference output, empty if the kernel is out of the evaluator's reach
+ */
+static fs::path evaluate_native_reference(const tsKernel& kernel, const fs::path& iter_dir, const string& iter_id, const CampaignConfig& cfg) {
+    fs::path out_file = iter_dir / "data" / "native_ref" / "results.tns";
+    try {
+        auto start = std::chrono::steady_clock::now();
+        EinsumEvalLimits limits;
+        limits.threads = cfg.native_ref_threads;
+
+        // Dense loops while the iteration space is small, pairwise sparse contractions beyond
+        vector<double> values;
+        tsTensorData sparse_values;
+        bool dense = evaluate_einsum(kernel, values, limits);
+        if (!dense && !evaluate_einsum_sparse(kernel, sparse_values, limits)) return {};
+
+        fs::create_directories(out_file.parent_path());
+        bool written = dense ? write_reference_result(kernel.tensors[0].shape, values, out_file.string())
+                             : write_reference_result(kernel.tensors[0].shape, sparse_values, out_file.string());
+        if (!written) return {};
+        std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - start;
+        record_timing(cfg.out_root / "timings.csv", iter_id, "native", "reference", 0, wall.count(), wall.count());
+    } catch (const std::exception& e) {
+        LOG_WARN("Native reference failed for " + iter_id + ": " + e.what());
+        return {};
+    }
+    return out_file;
+}
+
+/**
+ * @brief The core fuzzing task executed by a single worker thread.
+ * The kernel, its input data and its mutants are generated once and shared by every target backend.
+ */
+void FuzzingJob(size_t iter, vector<TargetBackend>& targets, const CampaignConfig& cfg) {
+    // Every stage draws from its own stream of (FUZZ_SEED, iter), so a job is reproducible on its own
+    tsRng local_rng = job_rng(iter, RngStage::EINSUM);
+    tsRng data_rng = job_rng(iter, RngStage::TENSOR_DATA);
+    tsRng mutation_rng = job_rng(iter, RngStage::MUTATION);
+    tsRng compare_rng = job_rng(iter, RngStage::COMPARISON);
+
+    std::uniform_int_distribution<int> dist_tensor_count(cfg.profile.min_inputs, cfg.profile.max_inputs);
 
     try {
         if (g_terminate) return;
@@ -180,8 +588,8 @@ void FuzzingJob(size_t iter, FuzzBackend* target_backend, std::mt19937::result_t
         LOG_INFO("Starting Fuzzing Job: " + iter_id);
         
         // Define paths
-        fs::path iter_dir = out_root / "corpus" / iter_id;
-        fs::path fail_dir = out_root / "failures";
+        fs::path iter_dir = cfg.work_root / "corpus" / iter_id;
+        fs::path fail_dir = cfg.out_root / "failures";
         fs::path iter_data_dir = iter_dir / "data";
         fs::create_directories(iter_dir);
         fs::create_directories(iter_data_dir);
@@ -191,13 +599,17 @@ void FuzzingJob(size_t iter, FuzzBackend* target_backend, std::mt19937::result_t
             fs::path& _iter_dir;
             fs::path& _fail_dir;
             std::string& _iter_id;
+            bool _transient;
 
             ~JobFinalizer() {
                 g_completed_runs++;
 
-                bool is_iter_archived = fs::exists(_fail_dir / "ref_crash" / _iter_id) ||
+                // Failures are copied to disk when archived, so an in-memory iteration can always go
+                bool is_iter_archived = !_transient && (
+                                        fs::exists(_fail_dir / "ref_crash" / _iter_id) ||
                                         fs::exists(_fail_dir / "crash" / _iter_id) ||
-                                        fs::exists(_fail_dir / "wc" / _iter_id);
+                                        fs::exists(_fail_dir / "wc" / _iter_id) ||
+                                        fs::exists(_fail_dir / "xbackend" / _iter_id));
                 
                 if (!is_iter_archived && fs::exists(_iter_dir)) {
                     try {
@@ -205,10 +617,21 @@ void FuzzingJob(size_t iter, FuzzBackend* target_backend, std::mt19937::result_t
                     } catch (...) {}
                 }
             }
-        } finalizer{iter_dir, fail_dir, iter_id};
+        } finalizer{iter_dir, fail_dir, iter_id, cfg.transient_corpus};
 
-        // Generate random kernel specification
-        auto [tensors, einsum] = generate_random_einsum(dist_tensor_count(local_rng), 6);
+        // Generate random kernel specification, either around a dataset tensor or fully synthetic
+        vector<tsTensor> tensors;
+        string einsum;
+        map<char, const DatasetTensor*> fixed_data;
+        shared_ptr<const DatasetTensor> dataset;
+        if (cfg.datasets && std::bernoulli_distribution(cfg.dataset_prob)(local_rng))
+            dataset = cfg.datasets->pick(local_rng);
+        if (dataset) {
+            tie(tensors, einsum) = generate_dataset_einsum(*dataset, dist_tensor_count(local_rng), local_rng);
+            fixed_data['B'] = dataset.get();
+        } else {
+            tie(tensors, einsum) = generate_random_einsum(dist_tensor_count(local_rng), cfg.profile.max_rank, local_rng, cfg.profile.index_pool, cfg.profile.dims);
+        }
         // auto [tensors, einsum] = generate_random_einsum(to_string(iter));
         // if (!is_valid_einsum_equation(einsum)) {
         //     return;
@@ -218,7 +641,7 @@ void FuzzingJob(size_t iter, FuzzBackend* target_backend, std::mt19937::result_t
         LOG_INFO("Generated Random Einsum: " + einsum);
         
         // Generate and store data for tensors
-        std::vector<std::string> datafile_names = generate_random_tensor_data(tensors, iter_data_dir, "", tensor_file_format);
+        std::vector<std::string> datafile_names = generate_random_tensor_data(tensors, iter_data_dir, "", cfg.tensor_file_format, data_rng, cfg.sparsity_pattern, fixed_data, cfg.data_pool, cfg.profile.data);
 
         if (datafile_names.size() != tensors.size() - 1) { 
             LOG_ERROR("Tensor data generation failed for job: " + iter_id);
@@ -226,87 +649,49 @@ void FuzzingJob(size_t iter, FuzzBackend* target_backend, std::mt19937::result_t
         }
 
         // Generate Reference Kernel (using the ref_backend)
-        if (!generate_ref_kernel(tensors, {einsum}, datafile_names, (iter_dir / "kernel.json").string())) {
+        tsKernel ref_kernel;
+        if (!generate_ref_kernel(tensors, {einsum}, datafile_names, (iter_dir / "kernel.json").string(), &ref_kernel)) {
             LOG_WARN("Reference Backend Kernel Generation Failed.");
             return;
         }
 
-        // Generate Mutants
-        // We reuse the existing logic which mutates the kernel.json file directly
-        vector<string> mutated_file_names = mutate_equivalent_kernel(iter_dir, "kernel.json", 10);
-        LOG_INFO("Generated " + to_string(mutated_file_names.size() - 1) + " Equivalent Mutants.");
-
-        // Generate the backend specific kernel
-        fs::path backend_kernel = iter_dir / "backend_kernel";
-        fs::create_directories(backend_kernel);
-        bool gen_ok = target_backend->generate_kernel(mutated_file_names, backend_kernel);
-        if (!gen_ok) {
-            cerr << "generate_kernel failed for iter " << iter_id << "\n";
-            LOG_WARN("generate_kernel failed for iter " + iter_id + " to generate mutated backend kernels.");
-            return;
+        // Evaluate the kernel in-process; kernels it cannot handle fall back to the backend reference
+        fs::path native_ref;
+        if (cfg.native_ref) {
+            native_ref = evaluate_native_reference(ref_kernel, iter_dir, iter_id, cfg);
         }
 
-        // Run reference executor (trusted) once to produce expected outputs
-        uint64_t timeout = executor_timeout_ms; // Use CLI-defined timeout
-        fs::path ref_out_dir = iter_data_dir / "ref_out";
-        fs::create_directories(ref_out_dir);
-        
-        // Use the generated reference kernel path
-        // TODO: Make it generic
-        string ref_kernel_filename = (backend_kernel / "kernel/backend_kernel.cpp");
+        // Generate Mutants in memory, one scheduled operator each; their JSON files are only written for backends that read them
+        vector<MutationOperator> mutation_ops;
+        vector<tsKernel> kernels = mutate_equivalent_kernels(ref_kernel, mutation_rng, cfg.max_mutants, *cfg.op_scheduler, mutation_ops);
+        vector<string> kernel_files = mutant_kernel_files(iter_dir, "kernel.json", kernels.size());
+        LOG_INFO("Generated " + to_string(kernels.size() - 1) + " Equivalent Mutants.");
 
-        int ref_result = run_with_timeout(target_backend, ref_kernel_filename, "", timeout);
+        // The reference output is all-Dense: compare results as flat arrays
+        const vector<TensorFormat>& out_format = tensors[0].storageFormat;
+        bool dense_output = all_of(out_format.begin(), out_format.end(), [](TensorFormat f) { return f == TensorFormat::tsDense; });
 
-        if (ref_result != 0) {
-            g_ref_crash_count++;
-            std::string message;
-            if (ref_result == -2) message = "Reference Kernel execution timed out";
-            else message = "Reference Kernel execution failed with code " + to_string(ref_result);
-            
-            LOG_INFO(message + ": " + iter_id);
-            archive_failure_case(iter_dir.stem().string(), iter_dir / "kernel", fail_dir / "ref_crash", message);
-            return; 
-        }
+        // Large outputs may be compared on a sample, except in a fraction of the iterations
+        bool sample_outputs = cfg.sampling.min_nnz > 0 && !std::bernoulli_distribution(cfg.sample_full_prob)(compare_rng);
+        uint64_t sample_seed = compare_rng();
 
-        // Run target on each mutant and compare outputs
-        LOG_INFO("Running mutants...");
-        
-        // Path to the reference result output file
-        string ref_out_file = (ref_out_dir / "results.tns").string();
-        
-        for (size_t mi = 1; mi < mutated_file_names.size() && !g_terminate; ++mi) {
-            fs::path mutant_path = backend_kernel / ("kernel" + to_string(mi)) / "backend_kernel.cpp";
-            
-            // Run target backend on the mutated kernel
-            int result = run_with_timeout(target_backend, mutant_path.string(), "", timeout);
-            
-            if (result != 0) {
-                // Crashing bug or timeout
-                if (result == -2) {
-                    // Timeout: Increase timeout and retry this mutant
-                    timeout += 4000;
-                    mi--; // Decrement to retry the current mutant
-                    continue;
-                }
-                // Actual Crashing Bug
-                g_crash_bug_count++;
-                LOG_INFO("CRASHING BUG FOUND IN MUTANT " + to_string(mi) + " of " + iter_id);
-                archive_failure_case(iter_id, mutant_path.parent_path(), fail_dir / "crash", "Mutated Kernel execution failed with code " + to_string(result));
-                break; // don't break, if you want to check whether other mutants also induce bugs
-            } 
-            
-            // Compare the results for a wrong code bug
-            string ref_out_file = (iter_data_dir / "ref_out" / "results.tns").string();
-            string mutant_out_file = mutant_path.parent_path() / "results.tns";
-            bool equal = target_backend->compare_results(ref_out_file, mutant_out_file);
-            
-            if (!equal) {
-                LOG_INFO("WRONG CODE BUG FOUND IN MUTANT " + to_string(mi) + " of " + iter_id);
-                g_wrong_code_count++;
-                archive_failure_case(iter_id, mutant_path.parent_path(), fail_dir / "wc", "Mutated Kernel produced incorrect results.");
-                break; // don't break, if you want to check whether other mutants also induce bugs
-            }
+        // Every backend runs the same kernels on the same data
+        bool multi_backend = targets.size() > 1;
+        vector<fs::path> ref_kernel_dirs;
+        vector<MutantOutcome> outcomes(kernels.size());
+        for (auto& target : targets) {
+            if (g_terminate) break;
+            ref_kernel_dirs.push_back(run_backend_iteration(target, multi_backend, kernels, mutation_ops, kernel_files, dense_output, sample_outputs ? &cfg.sampling : nullptr, sample_seed, native_ref, outcomes, iter_dir, iter_id, cfg));
         }
+
+        // Credit each operator with what its mutants produced; mutants that never ran cost nothing and say nothing
+        for (size_t mi = 1; mi < kernels.size(); ++mi)
+            if (outcomes[mi].wall_seconds > 0)
+                cfg.op_scheduler->update(mutation_ops[mi], outcomes[mi]);
+
+        // Extra oracle: all backends must agree on the reference kernel
+        if (multi_backend)
+            cross_check_backends(targets, ref_kernel_dirs, dense_output, iter_dir, iter_id, cfg);
         
         // Logging for progress
         if (iter % 100 == 0) {
@@ -334,14 +719,36 @@ void FuzzingJob(size_t iter, FuzzBackend* target_backend, std::mt19937::result_t
 // ---------- Program entry ----------
 int main(int argc, char* argv[]) {
     // CLI: minimal arg parsing for backend selection
-    string backend_so;
+    vector<string> backend_sos;
     uint64_t executor_timeout_ms = 30'000;
     string tensor_file_format = "tns";
+    InstancePolicy instance_policy = InstancePolicy::AUTO;
+    double cross_backend_tol = 1e-4;
+    string sparsity_pattern = "uniform";
+    string dataset_dir;
+    double dataset_prob = 0.5;
+    size_t writer_threads = 1;
+    bool use_shm = false;
+    fs::path shm_dir = "/dev/shm";
+    size_t data_pool_mb = 0;
+    double data_reuse_prob = 0.5;
+    size_t pool_threads = 1;
+    string profile_name = "default";
+    string profile_file;
+    SampleOptions sampling;
+    double sample_full_prob = 0.1;
+    bool native_ref = false;
+    size_t native_ref_threads = 1;
+    int max_mutants = 10;
+    // Uniform by default: UCB learns from jobs finishing in any order, so its runs are not reproducible
+    SchedulerPolicy scheduler_policy = SchedulerPolicy::UNIFORM;
+    string op_stats_file;
     // read CLI args simply
     for (int i = 1; i < argc; ++i) {
         string s = argv[i];
         if ((s == "--backend" || s == "-b") && i + 1 < argc) {
-            backend_so = argv[++i];
+            // May be repeated or given as a comma-separated list
+            for (auto& so : split(argv[++i], ',')) backend_sos.push_back(so);
         } else if ((s == "--timeout") && i + 1 < argc) {
             executor_timeout_ms = stoull(argv[++i]);
         } else if ((s == "--tensor-format" || s == "--tfmt") && i + 1 < argc) {
@@ -350,23 +757,103 @@ int main(int argc, char* argv[]) {
                             [](unsigned char c) { 
                                 return std::tolower(c); 
                             });
-            if (user_tfmt != "tns" && user_tfmt != "ttx")
+            if (user_tfmt != "tns" && user_tfmt != "ttx" && user_tfmt != "tsb")
             {
                 cerr << "Unsupported tensor storage format: " << user_tfmt << "\n";
             } else {
                 tensor_file_format = user_tfmt;
             }
+        } else if ((s == "--instance-policy") && i + 1 < argc) {
+            try {
+                instance_policy = parseInstancePolicy(argv[++i]);
+            } catch (const std::exception& e) {
+                cerr << e.what() << "\n";
+                return 1;
+            }
+        } else if ((s == "--cross-tol") && i + 1 < argc) {
+            cross_backend_tol = stod(argv[++i]);
+        } else if ((s == "--dataset") && i + 1 < argc) {
+            dataset_dir = argv[++i];
+        } else if ((s == "--dataset-prob") && i + 1 < argc) {
+            dataset_prob = stod(argv[++i]);
+        } else if ((s == "--writer-threads") && i + 1 < argc) {
+            writer_threads = stoull(argv[++i]);
+        } else if ((s == "--data-pool-mb") && i + 1 < argc) {
+            data_pool_mb = stoull(argv[++i]);
+        } else if ((s == "--data-reuse") && i + 1 < argc) {
+            data_reuse_prob = stod(argv[++i]);
+        } else if ((s == "--pool-threads") && i + 1 < argc) {
+            pool_threads = stoull(argv[++i]);
+        } else if ((s == "--profile") && i + 1 < argc) {
+            profile_name = argv[++i];
+        } else if ((s == "--profile-file") && i + 1 < argc) {
+            profile_file = argv[++i];
+        } else if ((s == "--sample-compare") && i + 1 < argc) {
+            sampling.min_nnz = stoull(argv[++i]);
+        } else if ((s == "--sample-confidence") && i + 1 < argc) {
+            sampling.confidence = stod(argv[++i]);
+        } else if ((s == "--sample-error-rate") && i + 1 < argc) {
+            sampling.error_rate = stod(argv[++i]);
+        } else if ((s == "--sample-full-prob") && i + 1 < argc) {
+            sample_full_prob = stod(argv[++i]);
+        } else if ((s == "--mutants") && i + 1 < argc) {
+            max_mutants = stoi(argv[++i]);
+        } else if ((s == "--op-scheduler") && i + 1 < argc) {
+            try {
+                scheduler_policy = parseSchedulerPolicy(argv[++i]);
+            } catch (const std::exception& e) {
+                cerr << e.what() << "\n";
+                return 1;
+            }
+        } else if ((s == "--op-stats") && i + 1 < argc) {
+            op_stats_file = argv[++i];
+        } else if (s == "--native-ref") {
+            native_ref = true;
+        } else if ((s == "--native-ref-threads") && i + 1 < argc) {
+            native_ref = true;
+            native_ref_threads = max<size_t>(1, stoull(argv[++i]));
+        } else if (s == "--shm") {
+            use_shm = true;
+        } else if ((s == "--shm-dir") && i + 1 < argc) {
+            use_shm = true;
+            shm_dir = argv[++i];
+        } else if ((s == "--pattern") && i + 1 < argc) {
+            sparsity_pattern = argv[++i];
+            if (sparsity_pattern != RANDOM_SPARSITY_PATTERN && !is_sparsity_pattern(sparsity_pattern)) {
+                cerr << "Unknown sparsity pattern: " << sparsity_pattern << " (available: " << join(sparsity_pattern_names(), ", ") << ", " << RANDOM_SPARSITY_PATTERN << ")\n";
+                return 1;
+            }
         } else {
             cerr << "Unknown arg: " << s << "\n";
         }
     }
 
+    if (sampling.min_nnz > 0) {
+        try {
+            sample_size(sampling);
+        } catch (const std::exception& e) {
+            cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+
     // allow env fallback
-    if (backend_so.empty()) {
-        if (const char* env = getenv("BACKEND_LIB")) backend_so = env;
+    if (backend_sos.empty()) {
+        if (const char* env = getenv("BACKEND_LIB")) backend_sos = split(env, ',');
     }
 
-    if (backend_so.empty()) {
+    // Profiles ship in config/profiles.json; TenSure normally runs from the build directory
+    if (profile_file.empty() && fs::exists("../config/profiles.json")) profile_file = "../config/profiles.json";
+    CampaignProfile profile;
+    try {
+        profile = load_campaign_profile(profile_file, profile_name);
+    } catch (const std::exception& e) {
+        cerr << e.what() << "\n";
+        return 1;
+    }
+    g_profile_json = profile.to_json();
+
+    if (backend_sos.empty()) {
         cerr << "No backend specified. Use --backend /path/to/libbackend.so or set BACKEND_LIB env var\n";
         return 1;
     }
@@ -385,7 +872,7 @@ int main(int argc, char* argv[]) {
     if (const char* env = getenv("FUZZ_SEED")) seed = std::stoull(env);
     if (const char* env2 = getenv("FUZZ_ITERS")) max_iterations = std::stoull(env2);
 
-    mt19937 rng(seed);
+    set_campaign_seed(seed);
 
     // Create dirs
     fs::create_directories(out_root);
@@ -399,53 +886,162 @@ int main(int argc, char* argv[]) {
     std::cout << "Starting fuzz loop with seed=" << seed << " up to " << max_iterations << " iterations\n";
     LOG_INFO("Starting fuzz loop with seed = " + to_string(seed) + " up to " + to_string(max_iterations) + " iterations");
 
-    // Load backend plugin (target)
-    PluginHandle target_ph;
-    try {
-        target_ph = load_plugin(backend_so);
-        std::cout << "Loaded backend: " << backend_so << "\n";
-        LOG_INFO("Loaded backend: " + backend_so);
-    } catch (const std::exception &e) {
-        cerr << "Failed to load backend " << backend_so << ": " << e.what() << "\n";
-        LOG_ERROR("Failed to load backend: " + backend_so + ": " + e.what());
-        return 1;
+    // Load backend plugins (targets). Each is opened with RTLD_LOCAL, so two builds of the same backend can coexist.
+    vector<TargetBackend> targets;
+    for (const auto& backend_so : backend_sos) {
+        TargetBackend target;
+        try {
+            target.plugin = load_plugin(backend_so);
+            std::cout << "Loaded backend: " << backend_so << "\n";
+            LOG_INFO("Loaded backend: " + backend_so + (target.plugin.thread_safe ? " (thread-safe)" : " (not thread-safe)"));
+        } catch (const std::exception &e) {
+            cerr << "Failed to load backend " << backend_so << ": " << e.what() << "\n";
+            LOG_ERROR("Failed to load backend: " + backend_so + ": " + e.what());
+            for (auto& t : targets) unload_plugin(t.plugin);
+            return 1;
+        }
+
+        // Tags name the per-backend directories, so they must be unique
+        string tag = backend_tag(backend_so);
+        target.tag = tag;
+        for (int n = 2; any_of(targets.begin(), targets.end(), [&](const TargetBackend& t) { return t.tag == target.tag; }); ++n)
+            target.tag = tag + "_" + to_string(n);
+        targets.push_back(std::move(target));
+    }
+
+    // Input files are written by background threads (0 = by the generating job itself)
+    configure_tensor_writer(writer_threads);
+
+    unique_ptr<DatasetCatalog> datasets;
+    if (!dataset_dir.empty()) {
+        try {
+            datasets = make_unique<DatasetCatalog>(dataset_dir);
+        } catch (const std::exception& e) {
+            cerr << "Cannot read dataset directory " << dataset_dir << ": " << e.what() << "\n";
+            for (auto& t : targets) unload_plugin(t.plugin);
+            return 1;
+        }
+        LOG_INFO("Dataset directory " + dataset_dir + ": " + to_string(datasets->size()) + " tensor files, used with probability " + to_string(dataset_prob));
+        if (datasets->empty()) datasets.reset();
+    }
+
+    // With --shm, inputs, kernels and results are exchanged through a tmpfs; only archived cases reach out_root
+    fs::path work_root = out_root;
+    if (use_shm) {
+        struct statvfs vfs;
+        if (!fs::is_directory(shm_dir) || statvfs(shm_dir.c_str(), &vfs) != 0) {
+            cerr << "Shared-memory directory " << shm_dir << " is not available, keeping the corpus in " << corpus_dir << "\n";
+            LOG_WARN("Shared-memory directory " + shm_dir.string() + " is not available, keeping the corpus on disk");
+            use_shm = false;
+        } else {
+            // Backends that build executables (TACO) run them from the kernel directories
+            if (vfs.f_flag & ST_NOEXEC)
+                LOG_WARN(shm_dir.string() + " is mounted noexec; kernels compiled to executables cannot run from it");
+            work_root = shm_dir / ("tensure-" + to_string(getpid()));
+            fs::remove_all(work_root);
+            fs::create_directories(work_root / "corpus");
+            LOG_INFO("Exchanging tensors through shared memory in " + work_root.string());
+        }
+    }
+
+    // Generated inputs are reused across iterations and refreshed by background threads
+    unique_ptr<TensorDataPool> data_pool;
+    if (data_pool_mb > 0) {
+        data_pool = make_unique<TensorDataPool>(work_root / "pool", data_pool_mb << 20, data_reuse_prob, pool_threads, seed);
+        LOG_INFO("Input data pool: " + to_string(data_pool_mb) + " MB, reuse probability " + to_string(data_reuse_prob) + ", " + to_string(pool_threads) + " refresh threads");
+    }
+
+    // Operator statistics carry over from earlier campaigns only when asked for with --op-stats,
+    // so that a rerun with the same seed does not depend on what the previous run learned
+    OperatorScheduler op_scheduler(scheduler_policy);
+    bool load_op_stats = !op_stats_file.empty();
+    if (op_stats_file.empty()) op_stats_file = (out_root / "operator_stats.json").string();
+    if (load_op_stats && fs::exists(op_stats_file)) {
+        try {
+            op_scheduler.load(op_stats_file);
+            LOG_INFO("Loaded mutation operator statistics from " + op_stats_file + ":\n" + op_scheduler.report());
+        } catch (const std::exception& e) {
+            LOG_WARN(string(e.what()) + "; starting from empty statistics");
+        }
     }
-    FuzzBackend* target_backend = target_ph.inst;
+    if (none_of(targets.begin(), targets.end(), [](const TargetBackend& t) { return t.plugin.supports_schedules; }))
+        op_scheduler.disable(SCHEDULE);
+    LOG_INFO("Mutation operator scheduler: " + to_string(scheduler_policy));
+    if (scheduler_policy == SchedulerPolicy::UCB)
+        LOG_WARN("--op-scheduler ucb picks operators from the outcomes of earlier jobs: the mutants of this run cannot be reproduced from FUZZ_SEED");
+
+    CampaignConfig cfg{out_root, tensor_file_format, executor_timeout_ms, cross_backend_tol, sparsity_pattern, datasets.get(), dataset_prob, work_root, use_shm, data_pool.get(), profile, sampling, sample_full_prob, native_ref, native_ref_threads, max_mutants, &op_scheduler};
+    LOG_INFO("Campaign profile " + profile.name + ": " + g_profile_json.dump());
+    LOG_INFO("Input sparsity pattern: " + sparsity_pattern);
+    LOG_INFO(string("Dense output comparison: ") + dense_compare_isa());
+    if (sampling.min_nnz > 0)
+        LOG_INFO("Sampled comparison of outputs with at least " + to_string(sampling.min_nnz) + " nonzeros: " + to_string(sample_size(sampling)) + " entries per comparison, " + to_string(sample_full_prob) + " of the iterations in full");
 
     const size_t num_threads = std::thread::hardware_concurrency();
     size_t actual_threads = (num_threads == 0) ? 4 : num_threads;
     std::cout << "Starting Thread Pool with " << actual_threads << " workers.\n";
 
-    ThreadPool pool(actual_threads);
+    {
+        for (auto& target : targets) {
+            target.instances = make_unique<BackendInstances>(target.plugin, instance_policy, actual_threads);
+            LOG_INFO("Backend instance policy for " + target.tag + ": " + to_string(target.instances->policy()));
+        }
 
-    // The Producer Loop: Queues tasks up to max_iterations
-    for (size_t iter = 0; iter < max_iterations && !g_terminate; ++iter) {
-        
-        // Enqueue the fuzzing job (wrapped in a lambda)
-        // We capture shared read-only pointers and config by value/reference.
-        // We pass the RNG seed offset (iter) instead of the RNG object itself.
-        pool.enqueue([=, &out_root]() mutable {
-            FuzzingJob(iter, target_backend, rng(), out_root, tensor_file_format, executor_timeout_ms);
-        });
-
-        // Throttle the producer if too far ahead (optional, but prevents massive queueing if workers are slow)
-        // Check if the number of tasks in the queue exceeds a safe threshold (e.g., 2x threads)
-        while ((iter - g_completed_runs.load()) > actual_threads * 2 && !g_terminate) {
-             std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        // Declared after the backend instances so that workers are joined before instances are destroyed
+        ThreadPool pool(actual_threads);
+
+        // The Producer Loop: Queues tasks up to max_iterations
+        for (size_t iter = 0; iter < max_iterations && !g_terminate; ++iter) {
+            
+            // Enqueue the fuzzing job (wrapped in a lambda)
+            // We capture shared read-only pointers and config by value/reference.
+            // Randomness comes from the job's own streams (see tensure/rng.hpp), derived from the seed and iter.
+            pool.enqueue([=, &cfg, &targets]() {
+                FuzzingJob(iter, targets, cfg);
+            });
+
+            // Throttle the producer if too far ahead (optional, but prevents massive queueing if workers are slow)
+            // Check if the number of tasks in the queue exceeds a safe threshold (e.g., 2x threads)
+            while ((iter - g_completed_runs.load()) > actual_threads * 2 && !g_terminate) {
+                 std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            }
         }
+
+        std::cout << "All fuzzing jobs successfully queued.\n";
+
+        // Monitoring Loop (Kept as is)
+        size_t last_count = 0;
+        while (g_completed_runs < max_iterations && !g_terminate) {
+            std::this_thread::sleep_for(std::chrono::seconds(10));
+            size_t current_count = g_completed_runs.load();
+            size_t rate = (current_count - last_count) / 10;
+            std::cout << "Progress: " << current_count << " / " << max_iterations 
+                      << " | Rate: " << rate << " runs/sec\n";
+            last_count = current_count;
+            op_scheduler.save(op_stats_file);
+        }
+    } // workers joined
+
+    // backend instances are destroyed before their plugins are unloaded
+    for (auto& target : targets) target.instances.reset();
+
+    if (data_pool) {
+        LOG_INFO("Input data pool: " + to_string(data_pool->hits()) + " reused, " + to_string(data_pool->misses()) + " generated by jobs");
+        data_pool.reset();
     }
 
-    std::cout << "All fuzzing jobs successfully queued.\n";
+    op_scheduler.save(op_stats_file);
+    LOG_INFO("Mutation operators:\n" + op_scheduler.report());
+
+    CompareStats compare_counts = compare_stats();
+    LOG_INFO("Output comparisons: " + to_string(compare_counts.comparisons) + ", " + to_string(compare_counts.fingerprint_hits) + " decided by fingerprints, " + to_string(compare_counts.sampled) + " by samples (" + to_string(compare_counts.escalated) + " escalated)");
+    // Matching outputs whose fingerprints never agree: the writers' copies of the hash have drifted apart
+    if (compare_counts.fingerprint_hits == 0 && compare_counts.fingerprint_misses >= MIN_FINGERPRINT_MISSES)
+        LOG_WARN("None of the " + to_string(compare_counts.fingerprint_misses) + " matching outputs with fingerprints had an equal fingerprint; the result writers' fingerprint hashes may disagree (see FINGERPRINT_TEST_HASH)");
 
-    // Monitoring Loop (Kept as is)
-    size_t last_count = 0;
-    while (g_completed_runs < max_iterations && !g_terminate) {
-        std::this_thread::sleep_for(std::chrono::seconds(10));
-        size_t current_count = g_completed_runs.load();
-        size_t rate = (current_count - last_count) / 10;
-        std::cout << "Progress: " << current_count << " / " << max_iterations 
-                  << " | Rate: " << rate << " runs/sec\n";
-        last_count = current_count;
+    if (use_shm) {
+        std::error_code ec;
+        fs::remove_all(work_root, ec);
     }
 
     std::cout << "Fuzzing loop finished (terminated=" << g_terminate << ")\n";
@@ -453,11 +1049,13 @@ int main(int argc, char* argv[]) {
     LOG_INFO("Total reference program crash iteration: " + to_string(g_ref_crash_count));
     LOG_INFO("Total Crashing bugs: " + to_string(g_crash_bug_count));
     LOG_INFO("Total Wrong Code bugs: " + to_string(g_wrong_code_count));
+    if (targets.size() > 1)
+        LOG_INFO("Total Cross-backend mismatches: " + to_string(g_cross_backend_count));
     LOG_INFO("Total Valid Einsum Generated: " + to_string(g_valid_einsum_count));
     LOG_INFO("Fuzzing loop finished (terminated=" + to_string(g_terminate));
 
     // unload plugins
-    unload_plugin(target_ph);
+    for (auto& target : targets) unload_plugin(target.plugin);
 
     return 0;
 }
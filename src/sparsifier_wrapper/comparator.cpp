@@ -0,0 +1,16 @@
+#include "sparsifier_wrapper/comparator.hpp"
+#include "tensure/utils.hpp"
+
+namespace sparsifier_wrapper {
+
+bool compare_outputs(const std::string& ref_output, const std::string& kernel_output, double tol)
+{
+    return ::compare_outputs(ref_output, kernel_output, tol);
+}
+
+bool compare_outputs(const ReferenceOutput& ref, const std::string& kernel_output, double tol)
+{
+    return ref.matches(kernel_output, tol);
+}
+
+}
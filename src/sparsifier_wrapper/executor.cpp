@@ -0,0 +1,327 @@
+#include "sparsifier_wrapper/executor.hpp"
+#include "tensure/tensor_io.hpp"
+#include "tensure/comparator.hpp"
+
+#include "mlir/Dialect/SparseTensor/Pipelines/Passes.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/InitAllDialects.h"
+#include "mlir/InitAllExtensions.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Target/LLVMIR/Dialect/All.h"
+#include "llvm/Support/TargetSelect.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <sstream>
+
+#ifndef MLIR_C_RUNNER_UTILS_LIB
+#define MLIR_C_RUNNER_UTILS_LIB "libmlir_c_runner_utils.so"
+#endif
+
+namespace sparsifier_wrapper {
+
+namespace {
+
+void init_llvm_once()
+{
+    static once_flag flag;
+    call_once(flag, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+    });
+}
+
+// Memref descriptor laid out like StridedMemRefType<T, rank>:
+// { allocated, aligned, offset, sizes[rank], strides[rank] }
+typedef struct MemRefDescriptor {
+    vector<int64_t> words;
+    size_t rank;
+
+    explicit MemRefDescriptor(size_t r) : words(3 + 2 * r, 0), rank(r) {}
+
+    static MemRefDescriptor wrap(const void* data, const vector<int64_t>& shape)
+    {
+        MemRefDescriptor desc(shape.size());
+        desc.words[0] = reinterpret_cast<intptr_t>(data);
+        desc.words[1] = reinterpret_cast<intptr_t>(data);
+        int64_t stride = 1;
+        for (size_t d = shape.size(); d-- > 0;)
+        {
+            desc.words[3 + d] = shape[d];
+            desc.words[3 + shape.size() + d] = stride;
+            stride *= shape[d];
+        }
+        return desc;
+    }
+
+    void* allocated() const { return reinterpret_cast<void*>(static_cast<intptr_t>(words[0])); }
+    const double* aligned() const { return reinterpret_cast<const double*>(static_cast<intptr_t>(words[1])); }
+    int64_t offset() const { return words[2]; }
+    void* data() { return words.data(); }
+} MemRefDescriptor;
+
+// Several results come back packed in one struct; here rank-1 memrefs of 5 words each
+// (the coordinate buffers of a sparse output, then its values)
+typedef struct PackedResults {
+    vector<int64_t> words;
+
+    explicit PackedResults(size_t count) : words(5 * count, 0) {}
+
+    void* allocated(size_t r) const { return reinterpret_cast<void*>(static_cast<intptr_t>(words[5 * r])); }
+    template <typename T> const T* aligned(size_t r) const { return reinterpret_cast<const T*>(static_cast<intptr_t>(words[5 * r + 1])) + words[5 * r + 2]; }
+    int64_t size(size_t r) const { return words[5 * r + 3]; }
+    void* data() { return words.data(); }
+} PackedResults;
+
+// Write the nonzeros of the output in the .tns layout used by the other backends (1-based)
+bool write_results(size_t rank, size_t entries, const function<int64_t(size_t, size_t)>& coord, const function<double(size_t)>& value, const fs::path& file)
+{
+    ofstream out(file);
+    if (!out)
+    {
+        cerr << "Error: could not open file " << file << endl;
+        return false;
+    }
+    out << setprecision(numeric_limits<double>::max_digits10);
+
+    OutputFingerprint fingerprint(rank);
+    vector<int64_t> written(rank);
+    for (size_t n = 0; n < entries; n++)
+    {
+        double v = value(n);
+        if (v == 0.0) continue;
+        for (size_t d = 0; d < rank; d++)
+        {
+            written[d] = coord(n, d) + 1;
+            out << written[d] << " ";
+        }
+        out << v << "\n";
+        fingerprint.add(written.data(), v);
+    }
+    out.close();
+    if (!out)
+        return false;
+    fingerprint.save(fingerprint_file(file.string()));
+    return true;
+}
+
+}
+
+JitExecutor::JitExecutor()
+{
+    init_llvm_once();
+
+    mlir::DialectRegistry registry;
+    mlir::registerAllDialects(registry);
+    mlir::registerAllExtensions(registry);
+    mlir::registerAllToLLVMIRTranslations(registry);
+
+    context_ = make_unique<mlir::MLIRContext>(registry);
+    // Every worker owns its own executor; a per-context thread pool would only oversubscribe the cores
+    context_->disableMultithreading();
+    context_->loadAllAvailableDialects();
+}
+
+JitExecutor::~JitExecutor() = default;
+
+void JitExecutor::clear_input_cache()
+{
+    input_cache_.clear();
+}
+
+const CooBuffer& JitExecutor::load_input(const string& data_file, const vector<int>& shape)
+{
+    auto it = input_cache_.find(data_file);
+    if (it != input_cache_.end())
+        return it->second;
+
+    CooBuffer buffer;
+    buffer.coordinates.resize(shape.size());
+
+    auto append = [&](auto coord_at, double value, const string& where) {
+        for (size_t d = 0; d < shape.size(); d++)
+        {
+            int64_t c = coord_at(d);
+            if (c < 0 || c >= shape[d])
+                throw runtime_error("Coordinate out of range in " + data_file + where);
+            buffer.coordinates[d].push_back(c);
+        }
+        buffer.values.push_back(value);
+    };
+
+    // Binary inputs are copied straight from the mapping
+    if (fs::path(data_file).extension() == ".tsb")
+    {
+        MappedTensorFile file(data_file);
+        if (file.rank() != shape.size())
+            throw runtime_error("Rank mismatch in " + data_file);
+        for (auto& coords : buffer.coordinates)
+            coords.reserve(file.nnz());
+        buffer.values.reserve(file.nnz());
+        for (uint64_t n = 0; n < file.nnz(); n++)
+            append([&](size_t d) { return static_cast<int64_t>(file.coords(d)[n]) - file.index_base(); }, file.values()[n], "");
+    } else {
+        ifstream in(data_file);
+        if (!in.is_open())
+            throw runtime_error("Cannot open " + data_file);
+
+        // Generated .tns/.ttx inputs use 0-based coordinates; .ttx has one extra header line with the shape
+        bool skip_dims = fs::path(data_file).extension() == ".ttx";
+        string line;
+        vector<double> tokens;
+        while (getline(in, line))
+        {
+            if (line.empty() || line[0] == '%' || line[0] == '#') continue;
+            if (skip_dims)
+            {
+                skip_dims = false;
+                continue;
+            }
+
+            istringstream iss(line);
+            tokens.clear();
+            double tok;
+            while (iss >> tok) tokens.push_back(tok);
+            if (tokens.size() != shape.size() + 1)
+                throw runtime_error("Malformed line in " + data_file + ": " + line);
+
+            append([&](size_t d) { return static_cast<int64_t>(tokens[d]); }, tokens.back(), ": " + line);
+        }
+    }
+
+    // A scalar is passed as a dense tensor of one element
+    if (shape.empty())
+        buffer.values.resize(1, 0.0);
+    buffer.positions = {0, static_cast<int64_t>(buffer.values.size())};
+    return input_cache_.emplace(data_file, std::move(buffer)).first->second;
+}
+
+int JitExecutor::run_kernel(const string& mlir_source, const tsKernel& kernel, const vector<fs::path>& results_file)
+{
+    auto compile_start_time = chrono::high_resolution_clock::now();
+
+    // 1. Parse
+    mlir::OwningOpRef<mlir::ModuleOp> module = mlir::parseSourceString<mlir::ModuleOp>(mlir_source, context_.get());
+    if (!module)
+    {
+        cerr << "Failed to parse MLIR kernel" << endl;
+        return JIT_PARSE_FAILED;
+    }
+
+    // 2. Lower with the sparsifier pipeline down to the LLVM dialect
+    mlir::PassManager pm(context_.get());
+    mlir::sparse_tensor::SparsifierOptions options;
+    mlir::sparse_tensor::buildSparsifier(pm, options);
+    if (mlir::failed(pm.run(*module)))
+    {
+        cerr << "Sparsifier pipeline failed" << endl;
+        return JIT_LOWERING_FAILED;
+    }
+
+    // 3. JIT (the sparse runtime support lives in the C runner utils)
+    mlir::ExecutionEngineOptions engine_options;
+    engine_options.transformer = mlir::makeOptimizingTransformer(2, 0, nullptr);
+    string runner_utils = MLIR_C_RUNNER_UTILS_LIB;
+    llvm::SmallVector<llvm::StringRef, 1> shared_libs = {runner_utils};
+    engine_options.sharedLibPaths = shared_libs;
+
+    auto maybe_engine = mlir::ExecutionEngine::create(*module, engine_options);
+    if (!maybe_engine)
+    {
+        cerr << "Failed to create execution engine: " << llvm::toString(maybe_engine.takeError()) << endl;
+        return JIT_ENGINE_FAILED;
+    }
+    auto engine = std::move(*maybe_engine);
+    auto compile_end_time = chrono::high_resolution_clock::now();
+
+    // 4. Feed the inputs from memory, as COO level buffers: memory follows nnz, not the volume
+    vector<MemRefDescriptor> inputs;
+    try {
+        for (size_t i = 1; i < kernel.tensors.size(); i++)
+        {
+            const tsTensor& t = kernel.tensors[i];
+            const CooBuffer& buffer = load_input(kernel.dataFileNames.at(string(1, t.name)), t.shape);
+            if (t.shape.empty())
+            {
+                inputs.push_back(MemRefDescriptor::wrap(buffer.values.data(), {}));
+                continue;
+            }
+            int64_t nnz = static_cast<int64_t>(buffer.values.size());
+            inputs.push_back(MemRefDescriptor::wrap(buffer.positions.data(), {2}));
+            for (const auto& coords : buffer.coordinates)
+                inputs.push_back(MemRefDescriptor::wrap(coords.data(), {nnz}));
+            inputs.push_back(MemRefDescriptor::wrap(buffer.values.data(), {nnz}));
+        }
+    } catch (const exception& e) {
+        cerr << "Failed to load kernel inputs: " << e.what() << endl;
+        return JIT_IO_FAILED;
+    }
+
+    // _mlir_ciface_kernel(results*, input*...): every packed argument is a pointer to the argument
+    // value; the results come first, as one struct (a sparse output) or one memref (a scalar)
+    size_t out_rank = kernel.tensors[0].shape.size();
+    PackedResults sparse_result(out_rank + 1);
+    MemRefDescriptor scalar_result(0);
+    vector<void*> arg_ptrs;
+    arg_ptrs.push_back(out_rank > 0 ? sparse_result.data() : scalar_result.data());
+    for (auto& input : inputs)
+        arg_ptrs.push_back(input.data());
+
+    vector<void*> packed;
+    for (auto& ptr : arg_ptrs)
+        packed.push_back(&ptr);
+
+    auto start_time = chrono::high_resolution_clock::now();
+    llvm::Error invoke_error = engine->invokePacked("_mlir_ciface_kernel", packed);
+    auto end_time = chrono::high_resolution_clock::now();
+    if (invoke_error)
+    {
+        cerr << "Kernel invocation failed: " << llvm::toString(std::move(invoke_error)) << endl;
+        return JIT_INVOKE_FAILED;
+    }
+
+    // 5. Results and timings
+    bool ok = true;
+    try {
+        for (const auto& file : results_file)
+        {
+            if (out_rank > 0)
+                ok = write_results(out_rank, sparse_result.size(out_rank),
+                                   [&](size_t n, size_t d) { return sparse_result.aligned<int64_t>(d)[n]; },
+                                   [&](size_t n) { return sparse_result.aligned<double>(out_rank)[n]; }, file) && ok;
+            else
+                ok = write_results(0, 1, nullptr, [&](size_t) { return scalar_result.aligned()[scalar_result.offset()]; }, file) && ok;
+        }
+    } catch (const exception& e) {
+        cerr << "Failed to write kernel results: " << e.what() << endl;
+        ok = false;
+    }
+    if (out_rank > 0)
+    {
+        for (size_t r = 0; r <= out_rank; r++)
+            free(sparse_result.allocated(r));
+    } else {
+        free(scalar_result.allocated());
+    }
+
+    chrono::duration<double, milli> compile_elapsed_ms = compile_end_time - compile_start_time;
+    chrono::duration<double, milli> compute_elapsed_ms = end_time - start_time;
+    fs::path time_file = results_file[0];
+    time_file.replace_extension(".txt");
+    ofstream time_out(time_file);
+    time_out << "Compilation time: " << compile_elapsed_ms.count() << " ms\n";
+    time_out << "Computation time: " << compute_elapsed_ms.count() << " ms\n";
+
+    return ok ? JIT_OK : JIT_IO_FAILED;
+}
+
+}
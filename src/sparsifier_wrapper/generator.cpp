@@ -0,0 +1,282 @@
+#include "sparsifier_wrapper/generator.hpp"
+
+namespace sparsifier_wrapper {
+
+static string dims_list(size_t rank)
+{
+    vector<string> dims;
+    for (size_t d = 0; d < rank; d++)
+        dims.push_back("d" + to_string(d));
+    return "(" + join(dims, ", ") + ")";
+}
+
+static string encoding_name(const tsTensor& t)
+{
+    return string("#enc_") + t.name;
+}
+
+// #sparse_tensor.encoding<{ map = (d0, d1) -> (d0 : dense, d1 : compressed) }>
+static string encoding_attr(const tsTensor& t)
+{
+    vector<string> levels;
+    for (size_t d = 0; d < t.storageFormat.size(); d++)
+    {
+        string level = (t.storageFormat[d] == TensorFormat::tsSparse) ? "compressed" : "dense";
+        levels.push_back("d" + to_string(d) + " : " + level);
+    }
+    return "#sparse_tensor.encoding<{ map = " + dims_list(t.shape.size()) + " -> (" + join(levels, ", ") + ") }>";
+}
+
+static string coo_name(const tsTensor& t)
+{
+    return string("#coo_") + t.name;
+}
+
+// COO with one coordinate buffer per mode, as passed to assemble or returned by disassemble:
+// #sparse_tensor.encoding<{ map = (d0, d1) -> (d0 : compressed(nonunique), d1 : singleton(soa)) }>
+// Input files need not be sorted, so the input encodings are also nonordered.
+static string coo_attr(const tsTensor& t, bool ordered)
+{
+    vector<string> levels;
+    for (size_t d = 0; d < t.shape.size(); d++)
+    {
+        vector<string> props;
+        if (d == 0 && t.shape.size() > 1) props.push_back("nonunique");
+        if (!ordered) props.push_back("nonordered");
+        if (d > 0) props.push_back("soa");
+        string level = (d == 0) ? "compressed" : "singleton";
+        if (!props.empty()) level += "(" + join(props, ", ") + ")";
+        levels.push_back("d" + to_string(d) + " : " + level);
+    }
+    return "#sparse_tensor.encoding<{ map = " + dims_list(t.shape.size()) + " -> (" + join(levels, ", ") + ") }>";
+}
+
+// tensor<4x6xf64> or tensor<4x6xf64, #enc_B>; scalars never carry an encoding
+static string tensor_type(const tsTensor& t, bool encoded, const string& encoding = "")
+{
+    ostringstream oss;
+    oss << "tensor<";
+    for (int dim : t.shape)
+        oss << dim << "x";
+    oss << "f64";
+    if (encoded && !t.shape.empty())
+        oss << ", " << (encoding.empty() ? encoding_name(t) : encoding);
+    oss << ">";
+    return oss.str();
+}
+
+// Level buffers of a COO tensor: positions, then one coordinate buffer per mode
+static vector<string> coo_level_types(const tsTensor& t)
+{
+    vector<string> types = {"tensor<2xindex>"};
+    for (size_t d = 0; d < t.shape.size(); d++)
+        types.push_back("tensor<?xindex>");
+    return types;
+}
+
+static string indexing_map(const tsTensor& t, const vector<char>& loop_idxs)
+{
+    vector<string> results;
+    for (char idx : t.idxs)
+    {
+        size_t pos = find(loop_idxs.begin(), loop_idxs.end(), idx) - loop_idxs.begin();
+        results.push_back("d" + to_string(pos));
+    }
+    return "affine_map<" + dims_list(loop_idxs.size()) + " -> (" + join(results, ", ") + ")>";
+}
+
+string generate_mlir_module(const tsKernel& kernel)
+{
+    if (kernel.tensors.size() < 2)
+        throw runtime_error("kernel needs an output and at least one input tensor");
+
+    const tsTensor& out = kernel.tensors[0];
+    vector<tsTensor> inputs(kernel.tensors.begin() + 1, kernel.tensors.end());
+    vector<char> loop_idxs = find_idxs(kernel.tensors);
+    bool sparse_out = !out.shape.empty();
+
+    string space = "    ";
+    ostringstream oss;
+
+    // Encodings, and the COO encodings inputs arrive in and the output leaves in
+    for (const auto& t : kernel.tensors)
+    {
+        if (t.shape.empty()) continue;
+        oss << encoding_name(t) << " = " << encoding_attr(t) << "\n";
+        oss << coo_name(t) << " = " << coo_attr(t, &t == &kernel.tensors[0]) << "\n";
+    }
+    oss << "\n";
+
+    // Trait: one indexing map per operand (inputs, then output); indices missing from the output are reductions
+    vector<string> maps;
+    for (const auto& t : inputs)
+        maps.push_back(space + space + indexing_map(t, loop_idxs));
+    maps.push_back(space + space + indexing_map(out, loop_idxs));
+
+    vector<string> iterators;
+    for (char idx : loop_idxs)
+    {
+        bool parallel = find(out.idxs.begin(), out.idxs.end(), idx) != out.idxs.end();
+        iterators.push_back(parallel ? "\"parallel\"" : "\"reduction\"");
+    }
+
+    oss << "#trait = {\n"
+        << space << "indexing_maps = [\n" << join(maps, ",\n") << "\n" << space << "],\n"
+        << space << "iterator_types = [" << join(iterators, ", ") << "]\n"
+        << "}\n\n";
+
+    // Function signature: every input as the level buffers of a COO tensor (scalars as dense
+    // tensors), so that no buffer grows with the volume of a tensor
+    vector<string> args;
+    for (const auto& t : inputs)
+    {
+        string name = string(1, t.name);
+        if (t.shape.empty())
+        {
+            args.push_back("%" + name + ": " + tensor_type(t, false));
+            continue;
+        }
+        args.push_back("%" + name + "_pos: tensor<2xindex>");
+        for (size_t d = 0; d < t.shape.size(); d++)
+            args.push_back("%" + name + "_crd" + to_string(d) + ": tensor<?xindex>");
+        args.push_back("%" + name + "_val: tensor<?xf64>");
+    }
+
+    // A sparse output is returned the same way, without its positions
+    vector<string> results;
+    if (sparse_out)
+    {
+        for (size_t d = 0; d < out.shape.size(); d++)
+            results.push_back("tensor<?xindex>");
+        results.push_back("tensor<?xf64>");
+    } else {
+        results.push_back(tensor_type(out, false));
+    }
+
+    oss << "module {\n"
+        << space << "func.func @kernel(" << join(args, ", ") << ") -> (" << join(results, ", ") << ")"
+        << " attributes { llvm.emit_c_interface } {\n";
+
+    string body = space + space;
+    vector<string> operands, operand_types;
+    for (const auto& t : inputs)
+    {
+        string name = string(1, t.name);
+        if (t.shape.empty())
+        {
+            operands.push_back("%" + name);
+            operand_types.push_back(tensor_type(t, false));
+            continue;
+        }
+        vector<string> levels = {"%" + name + "_pos"};
+        for (size_t d = 0; d < t.shape.size(); d++)
+            levels.push_back("%" + name + "_crd" + to_string(d));
+        oss << body << "%" << name << "_coo = sparse_tensor.assemble (" << join(levels, ", ") << "), %" << name << "_val"
+            << " : (" << join(coo_level_types(t), ", ") << "), tensor<?xf64> to " << tensor_type(t, true, coo_name(t)) << "\n";
+        oss << body << "%" << name << "_s = sparse_tensor.convert %" << name << "_coo : "
+            << tensor_type(t, true, coo_name(t)) << " to " << tensor_type(t, true) << "\n";
+        operands.push_back("%" + name + "_s");
+        operand_types.push_back(tensor_type(t, true));
+    }
+
+    // Output init: sparse outputs start empty, dense (scalar) outputs are zero-filled
+    oss << body << "%zero = arith.constant 0.0 : f64\n";
+    if (sparse_out)
+    {
+        oss << body << "%init = tensor.empty() : " << tensor_type(out, true) << "\n";
+    } else {
+        oss << body << "%empty = tensor.empty() : " << tensor_type(out, false) << "\n"
+            << body << "%init = linalg.fill ins(%zero : f64) outs(%empty : " << tensor_type(out, false)
+            << ") -> " << tensor_type(out, false) << "\n";
+    }
+
+    // Body: a += b * c * ...
+    vector<string> block_args;
+    for (const auto& t : inputs)
+        block_args.push_back("%" + string(1, (char)tolower(t.name)) + ": f64");
+    block_args.push_back("%acc: f64");
+
+    oss << body << "%result = linalg.generic #trait\n"
+        << body << space << "ins(" << join(operands, ", ") << " : " << join(operand_types, ", ") << ")\n"
+        << body << space << "outs(%init : " << tensor_type(out, sparse_out) << ") {\n"
+        << body << space << "^bb0(" << join(block_args, ", ") << "):\n";
+
+    string inner = body + space + space;
+    string product = "%" + string(1, (char)tolower(inputs[0].name));
+    for (size_t i = 1; i < inputs.size(); i++)
+    {
+        string next = "%p" + to_string(i);
+        oss << inner << next << " = arith.mulf " << product << ", %" << (char)tolower(inputs[i].name) << " : f64\n";
+        product = next;
+    }
+    oss << inner << "%sum = arith.addf %acc, " << product << " : f64\n"
+        << inner << "linalg.yield %sum : f64\n"
+        << body << "} -> " << tensor_type(out, sparse_out) << "\n";
+
+    // Release the sparse copies (the assembled COO inputs alias the argument buffers)
+    for (size_t i = 0; i < operands.size(); i++)
+    {
+        if (!inputs[i].shape.empty())
+            oss << body << "bufferization.dealloc_tensor " << operands[i] << " : " << operand_types[i] << "\n";
+    }
+
+    if (sparse_out)
+    {
+        // Hand back the output as COO, in buffers sized by its number of entries
+        string coo_type = tensor_type(out, true, coo_name(out));
+        oss << body << "%coo = sparse_tensor.convert %result : " << tensor_type(out, true) << " to " << coo_type << "\n"
+            << body << "bufferization.dealloc_tensor %result : " << tensor_type(out, true) << "\n"
+            << body << "%nse = sparse_tensor.number_of_entries %coo : " << coo_type << "\n"
+            << body << "%pos_buf = tensor.empty() : tensor<2xindex>\n";
+        vector<string> level_bufs = {"%pos_buf"}, level_outs = {"%pos"}, level_lens = {"%pos_len"}, crd_outs;
+        for (size_t d = 0; d < out.shape.size(); d++)
+        {
+            string dim = to_string(d);
+            oss << body << "%crd" << dim << "_buf = tensor.empty(%nse) : tensor<?xindex>\n";
+            level_bufs.push_back("%crd" + dim + "_buf");
+            level_outs.push_back("%crd" + dim);
+            level_lens.push_back("%crd" + dim + "_len");
+            crd_outs.push_back("%crd" + dim);
+        }
+        oss << body << "%val_buf = tensor.empty(%nse) : tensor<?xf64>\n";
+
+        vector<string> len_types(level_lens.size(), "index");
+        oss << body << join(level_outs, ", ") << ", %val, " << join(level_lens, ", ") << ", %val_len = sparse_tensor.disassemble %coo : " << coo_type << "\n"
+            << body << space << "out_lvls(" << join(level_bufs, ", ") << " : " << join(coo_level_types(out), ", ") << ")\n"
+            << body << space << "out_vals(%val_buf : tensor<?xf64>)\n"
+            << body << space << "-> (" << join(coo_level_types(out), ", ") << "), tensor<?xf64>, (" << join(len_types, ", ") << "), index\n"
+            << body << "bufferization.dealloc_tensor %coo : " << coo_type << "\n"
+            << body << "return " << join(crd_outs, ", ") << ", %val : " << join(results, ", ") << "\n";
+    } else {
+        oss << body << "return %result : " << tensor_type(out, false) << "\n";
+    }
+
+    oss << space << "}\n"
+        << "}\n";
+    return oss.str();
+}
+
+string generate_sparsifier_kernel(const tsKernel& kernel, const fs::path& out_dir)
+{
+    try {
+        fs::create_directories(out_dir);
+        string module = generate_mlir_module(kernel);
+
+        // atomic write
+        fs::path tmp_name = out_dir / "kernel.mlir.tmp";
+        ofstream ofs(tmp_name);
+        ofs << module;
+        ofs.close();
+        fs::rename(tmp_name, out_dir / "kernel.mlir");
+
+        // Keep the specification next to the module so the kernel can be re-run from disk
+        tsKernel copy = kernel;
+        copy.saveJson((out_dir / "kernel.json").string());
+        return module;
+    } catch (const exception& e) {
+        cerr << "SparsifierBackend::generate_kernel failed: " << e.what() << endl;
+        return "";
+    }
+}
+
+}
@@ -1,19 +1,58 @@
 #include "sparsifier_wrapper/sparsifier_backend.hpp"
 
 bool SparsifierBackend::generate_kernel(const vector<string>& mutated_kernel_file_names, const fs::path& output_dir) {
-    cout << "GENERATE Sparsifier KERNELS" << endl;
-    
+    vector<tsKernel> kernels(mutated_kernel_file_names.size());
+    for (size_t i = 0; i < kernels.size(); i++)
+        kernels[i].loadJson(mutated_kernel_file_names[i]);
+    return generate_kernel(kernels, mutated_kernel_file_names, output_dir);
+}
+
+bool SparsifierBackend::generate_kernel(const vector<tsKernel>& kernels, const vector<string>& kernel_file_names, const fs::path& output_dir) {
+    // A new reference kernel starts a new iteration with new input data
+    prepared_.clear();
+    executor_.clear_input_cache();
+
+    for (size_t i = 0; i < kernels.size(); i++) {
+        fs::path p(kernel_file_names[i]);
+        fs::path kernel_dir = output_dir / p.stem();
+
+        PreparedKernel prepared;
+        prepared.kernel = kernels[i];
+        prepared.mlir_source = sparsifier_wrapper::generate_sparsifier_kernel(prepared.kernel, kernel_dir);
+        if (prepared.mlir_source.empty())
+            return false;
+
+        prepared.results_file = {kernel_dir / "results.tns"};
+        if (i == 0)
+            prepared.results_file.push_back(p.parent_path() / "data" / "ref_out" / "results.tns");
+
+        prepared_[kernel_dir] = std::move(prepared);
+    }
     return true;
 }
 
 int SparsifierBackend::execute_kernel(const fs::path& kernelPath, const fs::path& outputDir) {
-    cout << "EXECUTE Sparsifier KERNEL" << endl;
-    return 0;
+    // The core passes <kernel_dir>/backend_kernel.cpp; only the directory is meaningful here
+    fs::path kernel_dir = kernelPath.has_extension() ? kernelPath.parent_path() : kernelPath;
+
+    auto it = prepared_.find(kernel_dir);
+    if (it == prepared_.end()) {
+        cerr << "Sparsifier kernel was not generated: " << kernel_dir << endl;
+        return -1;
+    }
+
+    // Failing to read the inputs or write the output is the harness's problem, not the kernel's
+    const PreparedKernel& prepared = it->second;
+    int status = executor_.run_kernel(prepared.mlir_source, prepared.kernel, prepared.results_file);
+    return status == sparsifier_wrapper::JIT_IO_FAILED ? BACKEND_SKIPPED : status;
 }
 
 bool SparsifierBackend::compare_results(const string& refDir, const string& testDir) {
-    cout << "COMPARE Sparsifier RESULTS" << endl;
-    return true;
+    return sparsifier_wrapper::compare_outputs(refDir, testDir);
+}
+
+bool SparsifierBackend::compare_results(const ReferenceOutput& ref, const string& testDir) {
+    return sparsifier_wrapper::compare_outputs(ref, testDir);
 }
 
 // Plugin entry points
@@ -25,3 +64,7 @@ extern "C" void destroy_backend(FuzzBackend* backend) {
     delete backend;
 }
 
+// Each instance owns an MLIRContext and an input cache, so workers need their own instance
+extern "C" bool backend_thread_safe() {
+    return false;
+}
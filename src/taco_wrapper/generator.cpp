@@ -1,4 +1,7 @@
 #include "taco_wrapper/generator.hpp"
+#include "tensure/comparator.hpp"
+
+#include <iomanip>
 
 namespace taco_wrapper {
 
@@ -34,6 +37,79 @@ bool generate_taco_kernel(const tsKernel& kernel, const fs::path& out_file, std:
     return true;
 }
 
+// Size of an index variable, from the first tensor that uses it
+static int index_extent(const tsKernel &kernel_info, const string &var)
+{
+    for (const auto &tensor : kernel_info.tensors)
+        for (size_t d = 0; d < tensor.idxs.size() && d < tensor.shape.size(); d++)
+            if (string(1, tensor.idxs[d]) == var) return tensor.shape[d];
+    return 1;
+}
+
+// The schedule of the kernel's computation as transformations of its concrete index statement `stmt`.
+// Commands TACO's checks reject throw; they are skipped and counted in schedule_rejected.
+static string schedule_program(const tsKernel &kernel_info, const string &space)
+{
+    const vector<tsScheduleCommand> &schedule = kernel_info.computations[0].schedule;
+    char output = kernel_info.tensors[0].name;
+    const vector<char> &output_idxs = kernel_info.tensors[0].idxs;
+
+    ostringstream oss;
+    vector<string> new_vars;
+    for (const auto &cmd : schedule)
+        for (const auto &var : cmd.vars)
+            if (var.size() > 1 && find(new_vars.begin(), new_vars.end(), var) == new_vars.end()) new_vars.push_back(var);
+    for (size_t i = 0; i < new_vars.size(); i++)
+        oss << (i ? ", " : space + "IndexVar ") << new_vars[i] << "(\"" << new_vars[i] << "\")" << (i + 1 == new_vars.size() ? ";\n" : "");
+
+    oss << space << "IndexStmt stmt = " << output << ".getAssignment().concretize();\n";
+    oss << space << "int schedule_rejected = 0;\n";
+    for (const auto &cmd : schedule)
+    {
+        const vector<string> &v = cmd.vars;
+        string call;
+        if (cmd.command == "split" && v.size() == 3)
+            call = "stmt.split(" + v[0] + ", " + v[1] + ", " + v[2] + ", " + std::to_string(cmd.factor) + ")";
+        else if (cmd.command == "pos" && v.size() == 2)
+        {
+            string access;
+            for (const auto &tensor : kernel_info.tensors)
+                if (string(1, tensor.name) == cmd.tensor)
+                    access = cmd.tensor + "(" + join(tensor.idxs, ",") + ")";
+            if (access.empty()) continue;
+            call = "stmt.pos(" + v[0] + ", " + v[1] + ", " + access + ")";
+        }
+        else if (cmd.command == "reorder" && !v.empty())
+            call = "stmt.reorder({" + join(v, ", ") + "})";
+        else if (cmd.command == "unroll" && v.size() == 1)
+            call = "stmt.unroll(" + v[0] + ", " + std::to_string(cmd.factor) + ")";
+        else if (cmd.command == "parallelize" && v.size() == 1)
+        {
+            // Without a recorded source index, assume a reduction: atomics are safe either way
+            bool reduction = cmd.source.size() != 1 || find(output_idxs.begin(), output_idxs.end(), cmd.source[0]) == output_idxs.end();
+            call = "stmt.parallelize(" + v[0] + ", ParallelUnit::CPUThread, OutputRaceStrategy::" + (reduction ? "Atomics" : "NoRaces") + ")";
+        }
+        else if (cmd.command == "precompute" && v.size() == 1)
+        {
+            // Only legal over the innermost output index (see tsScheduleCommand)
+            if (output_idxs.empty() || v[0] != string(1, output_idxs.back())) continue;
+            oss << space << "TensorVar ws_" << v[0] << "(\"ws_" << v[0] << "\", Type(Float64, {Dimension(" << index_extent(kernel_info, v[0]) << ")}), Format({Dense}));\n";
+            call = "stmt.precompute(" + string(1, output) + ".getAssignment().getRhs(), " + v[0] + ", " + v[0] + ", ws_" + v[0] + ")";
+        }
+        else
+            continue;
+
+        oss << space << "try {\n"
+            << space << space << "stmt = " << call << ";\n"
+            << space << "} catch (const std::exception& e) {\n"
+            << space << space << "schedule_rejected++;\n"
+            << space << space << "std::cerr << \"Schedule command rejected: " << to_string(cmd) << ": \" << e.what() << \"\\n\";\n"
+            << space << "}\n";
+    }
+    oss << "\n";
+    return oss.str();
+}
+
 string generate_program(const tsKernel &kernel_info, std::vector<fs::path> results_file)
 {
     int tab_space_count = 4;
@@ -42,6 +118,10 @@ string generate_program(const tsKernel &kernel_info, std::vector<fs::path> resul
     {
             space += " ";
     }
+    ostringstream grid_str;
+    grid_str << setprecision(17) << FINGERPRINT_GRID;
+    string fingerprint_grid = grid_str.str();
+
     ostringstream oss;
     oss << "#include <iostream>\n" 
         << "#include <fstream>\n"
@@ -50,10 +130,163 @@ string generate_program(const tsKernel &kernel_info, std::vector<fs::path> resul
         << "#include <vector>\n" 
         << "#include <string>\n"
         << "#include <stdexcept>\n" 
+        << "#include <charconv>\n"
+        << "#include <cstdio>\n"
+        << "#include <cstring>\n"
+        << "#include <cstdint>\n"
+        << "#include <cmath>\n"
+        << "#include <fcntl.h>\n"
+        << "#include <sys/mman.h>\n"
+        << "#include <sys/stat.h>\n"
+        << "#include <unistd.h>\n"
         << "#include \"taco.h\"\n\n"
         << "using namespace taco;\n\n"
+        // .tns writer: std::to_chars into one reusable buffer, flushed with fwrite (1-based coordinates, like taco::write)
+        << "int write_tns_file(const std::string& file_name, const Tensor<double>& T)\n"
+            << "{\n\t"
+            << "FILE* f = std::fopen(file_name.c_str(), \"wb\");\n\t"
+            << "if (!f) return 1;\n\t"
+            << "std::vector<char> buf(1 << 20);\n\t"
+            << "char* const end = buf.data() + buf.size();\n\t"
+            << "char* p = buf.data();\n\t"
+            << "for (auto& value : iterate<double>(T)) {\n\t\t"
+                << "if (end - p < 512) {\n\t\t\t"
+                    << "std::fwrite(buf.data(), 1, p - buf.data(), f);\n\t\t\t"
+                    << "p = buf.data();\n\t\t"
+                << "}\n\t\t"
+                << "for (int coord : value.first) {\n\t\t\t"
+                    << "p = std::to_chars(p, end, coord + 1).ptr;\n\t\t\t"
+                    << "*p++ = ' ';\n\t\t"
+                << "}\n\t\t"
+                << "p = std::to_chars(p, end, value.second).ptr;\n\t\t"
+                << "*p++ = '\\n';\n\t"
+            << "}\n\t"
+            << "std::fwrite(buf.data(), 1, p - buf.data(), f);\n\t"
+            << "return std::fclose(f) == 0 ? 0 : 1;\n"
+        << "}\n\n"
+        // .tsb (TenSure binary, see tensure/tensor_io.hpp) reader: coordinate and value arrays used in place from an mmap
+        << "int read_tsb_file(const std::string& file_name, Tensor<double>& T)\n"
+            << "{\n\t"
+            << "int fd = open(file_name.c_str(), O_RDONLY);\n\t"
+            << "if (fd < 0) {\n\t\t"
+                << "throw std::runtime_error(\"Failed to open file: \" + file_name);\n\t"
+            << "}\n\t"
+            << "struct stat st;\n\t"
+            << "fstat(fd, &st);\n\t"
+            << "void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);\n\t"
+            << "close(fd);\n\t"
+            << "if (map == MAP_FAILED || st.st_size < 64 || std::memcmp(map, \"TSURETSB\", 8) != 0) {\n\t\t"
+                << "throw std::runtime_error(\"Not a TenSure binary tensor file: \" + file_name);\n\t"
+            << "}\n\t"
+            << "const char* base = static_cast<const char*>(map);\n\t"
+            << "uint32_t rank, index_base;\n\t"
+            << "uint64_t nnz;\n\t"
+            << "std::memcpy(&rank, base + 12, sizeof(rank));\n\t"
+            << "std::memcpy(&nnz, base + 16, sizeof(nnz));\n\t"
+            << "std::memcpy(&index_base, base + 24, sizeof(index_base));\n\t"
+            << "auto align = [](uint64_t bytes) { return (bytes + 63) / 64 * 64; };\n\t"
+            << "uint64_t offset = 64 + align(rank * sizeof(int64_t));\n\t"
+            << "std::vector<const int32_t*> coords(rank);\n\t"
+            << "for (uint32_t d = 0; d < rank; d++) {\n\t\t"
+                << "coords[d] = reinterpret_cast<const int32_t*>(base + offset);\n\t\t"
+                << "offset += align(nnz * sizeof(int32_t));\n\t"
+            << "}\n\t"
+            << "if (offset + nnz * sizeof(double) > static_cast<uint64_t>(st.st_size)) {\n\t\t"
+                << "throw std::runtime_error(\"Truncated tensor file: \" + file_name);\n\t"
+            << "}\n\t"
+            << "const double* values = reinterpret_cast<const double*>(base + offset);\n\t"
+            << "std::vector<int> coord(rank);\n\t"
+            << "for (uint64_t n = 0; n < nnz; n++) {\n\t\t"
+                << "for (uint32_t d = 0; d < rank; d++) {\n\t\t\t"
+                    << "coord[d] = coords[d][n] - static_cast<int>(index_base);\n\t\t"
+                << "}\n\t\t"
+                << "T.insert(coord, values[n]);\n\t"
+            << "}\n\t"
+            << "munmap(map, st.st_size);\n\t"
+            << "return 0;\n"
+        << "}\n\n"
+        // .tsb writer for results: 1-based coordinates, like the .tns results
+        << "int write_tsb_file(const std::string& file_name, const Tensor<double>& T)\n"
+            << "{\n\t"
+            << "std::vector<std::vector<int32_t>> coords(T.getOrder());\n\t"
+            << "std::vector<double> values;\n\t"
+            << "for (auto& value : iterate<double>(T)) {\n\t\t"
+                << "size_t d = 0;\n\t\t"
+                << "for (int coord : value.first) {\n\t\t\t"
+                    << "coords[d++].push_back(coord + 1);\n\t\t"
+                << "}\n\t\t"
+                << "values.push_back(value.second);\n\t"
+            << "}\n\t"
+            << "FILE* f = std::fopen(file_name.c_str(), \"wb\");\n\t"
+            << "if (!f) return 1;\n\t"
+            << "char header[64] = {};\n\t"
+            << "uint32_t version = 1, rank = static_cast<uint32_t>(coords.size()), index_base = 1;\n\t"
+            << "uint64_t nnz = values.size();\n\t"
+            << "std::memcpy(header, \"TSURETSB\", 8);\n\t"
+            << "std::memcpy(header + 8, &version, sizeof(version));\n\t"
+            << "std::memcpy(header + 12, &rank, sizeof(rank));\n\t"
+            << "std::memcpy(header + 16, &nnz, sizeof(nnz));\n\t"
+            << "std::memcpy(header + 24, &index_base, sizeof(index_base));\n\t"
+            << "std::fwrite(header, 1, sizeof(header), f);\n\t"
+            << "static const char zeros[64] = {};\n\t"
+            << "auto pad = [&](uint64_t bytes) { std::fwrite(zeros, 1, (64 - bytes % 64) % 64, f); };\n\t"
+            << "for (uint32_t d = 0; d < rank; d++) {\n\t\t"
+                << "int64_t dim = T.getDimension(d);\n\t\t"
+                << "std::fwrite(&dim, sizeof(dim), 1, f);\n\t"
+            << "}\n\t"
+            << "pad(rank * sizeof(int64_t));\n\t"
+            << "for (auto& c : coords) {\n\t\t"
+                << "std::fwrite(c.data(), sizeof(int32_t), c.size(), f);\n\t\t"
+                << "pad(c.size() * sizeof(int32_t));\n\t"
+            << "}\n\t"
+            << "std::fwrite(values.data(), sizeof(double), values.size(), f);\n\t"
+            << "return std::fclose(f) == 0 ? 0 : 1;\n"
+        << "}\n\n"
+        // Fingerprint of the result (see OutputFingerprint in tensure/comparator.hpp): same hash, same layout
+        << "int write_fingerprint_file(const std::string& file_name, const Tensor<double>& T)\n"
+            << "{\n\t"
+            << "const double grid = " << fingerprint_grid << ";\n\t"
+            << "auto mix64 = [](uint64_t x) {\n\t\t"
+                << "x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;\n\t\t"
+                << "x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ULL;\n\t\t"
+                << "return x ^ (x >> 33);\n\t"
+            << "};\n\t"
+            << "auto entry_hash = [&](const uint64_t* c, size_t order, double steps) {\n\t\t"
+                << "uint64_t h = 0x9E3779B97F4A7C15ULL;\n\t\t"
+                << "for (size_t d = 0; d < order; d++) h = mix64(h ^ c[d]);\n\t\t"
+                << "return mix64(h ^ static_cast<uint64_t>(std::llround(steps)));\n\t"
+            << "};\n\t"
+            // A hash that drifted from TenSure's would never match: write no fingerprint then
+            << "const uint64_t test_coords[2][2] = {{0, 1}, {2, 3}};\n\t"
+            << "if (entry_hash(test_coords[0], 2, 1.5 / grid) + entry_hash(test_coords[1], 2, -0.25 / grid) != "
+                << FINGERPRINT_TEST_HASH << "ULL) return 1;\n\t"
+            << "std::vector<uint64_t> coord_sums(T.getOrder(), 0), c(T.getOrder());\n\t"
+            << "uint64_t nnz = 0, value_hash = 0;\n\t"
+            << "for (auto& value : iterate<double>(T)) {\n\t\t"
+                << "if (value.second == 0.0) continue;\n\t\t"
+                << "double steps = value.second / grid;\n\t\t"
+                << "if (!(std::fabs(steps) < 9.0e18)) return 1;\n\t\t"
+                << "size_t d = 0;\n\t\t"
+                << "for (int coord : value.first) {\n\t\t\t"
+                    << "c[d] = static_cast<uint64_t>(static_cast<int64_t>(coord) + 1);\n\t\t\t"
+                    << "coord_sums[d] += c[d];\n\t\t\t"
+                    << "d++;\n\t\t"
+                << "}\n\t\t"
+                << "value_hash += entry_hash(c.data(), c.size(), steps);\n\t\t"
+                << "nnz++;\n\t"
+            << "}\n\t"
+            << "FILE* f = std::fopen(file_name.c_str(), \"w\");\n\t"
+            << "if (!f) return 1;\n\t"
+            << "std::fprintf(f, \"TSFP1 %.17g %zu %llu %llu\", grid, coord_sums.size(), (unsigned long long)nnz, (unsigned long long)value_hash);\n\t"
+            << "for (uint64_t sum : coord_sums) std::fprintf(f, \" %llu\", (unsigned long long)sum);\n\t"
+            << "std::fprintf(f, \"\\n\");\n\t"
+            << "return std::fclose(f) == 0 ? 0 : 1;\n"
+        << "}\n\n"
         << "int read_taco_file(std::string file_name, Tensor<double>& T)\n"
             <<"{\n\t"
+            << "if (file_name.size() > 4 && file_name.compare(file_name.size() - 4, 4, \".tsb\") == 0) {\n\t\t"
+                << "return read_tsb_file(file_name, T);\n\t"
+            << "}\n\t"
             << "std::ifstream file(file_name);\n\t"
             << "if (!file.is_open()) {\n\t\t"
                 << "throw std::runtime_error(\"Failed to open file: \" + file_name);\n\t"
@@ -104,8 +337,14 @@ string generate_program(const tsKernel &kernel_info, std::vector<fs::path> resul
     {
         oss << space << expression.expressions << ";\n\n";
     }
+
+    // Scheduled kernels compile the transformed statement instead of TACO's default one
+    bool scheduled = kernel_info.computations.size() == 1 && !kernel_info.computations[0].schedule.empty();
+    if (scheduled)
+        oss << schedule_program(kernel_info, space);
+
     oss << space << "auto compile_start_time = std::chrono::high_resolution_clock::now();\n";
-    oss << space << kernel_info.tensors[0].name << ".compile();\n";
+    oss << space << kernel_info.tensors[0].name << (scheduled ? ".compile(stmt);\n" : ".compile();\n");
     oss << space << kernel_info.tensors[0].name << ".assemble();\n";
     oss << space << "auto compile_end_time = std::chrono::high_resolution_clock::now();\n";
     oss << space << kernel_info.tensors[0].name << ".compute();\n\n";
@@ -118,11 +357,17 @@ string generate_program(const tsKernel &kernel_info, std::vector<fs::path> resul
     oss << space << "std::ofstream time_file(\"" << time_file.string() << "\");\n";
     oss << space << "time_file << \"Compilation time: \" << compile_elapsed_ms.count() << \" ms\"\n\"\";\n";
     oss << space << "time_file << \"Computation time: \" << compute_elapsed_ms.count() << \" ms\"\n\"\";\n";
+    if (scheduled)
+        oss << space << "time_file << \"\\nSchedule commands rejected: \" << schedule_rejected << \"\\n\";\n";
     oss << space << "time_file.close();\n";
 
     for (auto &results_file_path : results_file) {
         fs::path abs_results_file_path = std::filesystem::absolute(std::filesystem::current_path() / results_file_path);
-        oss << space << "write(\"" << abs_results_file_path.string() << "\", " << kernel_info.tensors[0].name << ");\n";
+        string writer = (abs_results_file_path.extension() == ".tsb") ? "write_tsb_file" : "write_tns_file";
+        fs::path fp_file = fingerprint_file(abs_results_file_path.string());
+        oss << space << "if (" << writer << "(\"" << abs_results_file_path.string() << "\", " << kernel_info.tensors[0].name << ") == 0) {\n"
+            << space << space << "write_fingerprint_file(\"" << fp_file.string() << "\", " << kernel_info.tensors[0].name << ");\n"
+            << space << "}\n";
     }
     oss << "\n" << space << "return 0;\n";
 
@@ -1,22 +1,33 @@
 #include "taco_wrapper/taco_backend.hpp"
 
 bool TacoBackend::generate_kernel(const vector<string>& mutated_kernel_file_names, const fs::path& output_dir) {
+    vector<tsKernel> kernels(mutated_kernel_file_names.size());
+    for (size_t i = 0; i < kernels.size(); i++)
+        kernels[i].loadJson(mutated_kernel_file_names[i]);
+    return generate_kernel(kernels, mutated_kernel_file_names, output_dir);
+}
+
+bool TacoBackend::generate_kernel(const vector<tsKernel>& kernels, const vector<string>& kernel_file_names, const fs::path& output_dir) {
     // Call your existing executor.cpp function
-    for (int i = 0; i < mutated_kernel_file_names.size(); i++) {
-        auto &mutated_file_name = mutated_kernel_file_names[i];
-        fs::path p(mutated_file_name);
+    for (size_t i = 0; i < kernels.size(); i++) {
+        const tsKernel& tskernel = kernels[i];
+        fs::path p(kernel_file_names[i]);
         fs::path taco_kernel_file = output_dir / (p.stem());
         fs::create_directories(taco_kernel_file);
-        tsKernel tskernel;
-        tskernel.loadJson(mutated_file_name);
+
+        // Results are written in binary when the campaign uses binary inputs, as text otherwise
+        string results_name = "results.tns";
+        for (const auto& [name, data_file] : tskernel.dataFileNames) {
+            if (fs::path(data_file).extension() == ".tsb") results_name = "results.tsb";
+        }
+
         if (i==0)
         {
-            taco_wrapper::generate_taco_kernel(tskernel, taco_kernel_file, {(taco_kernel_file / "results.tns"), (p.parent_path() / "data" / "ref_out" / "results.tns")});
+            taco_wrapper::generate_taco_kernel(tskernel, taco_kernel_file, {(taco_kernel_file / results_name), (p.parent_path() / "data" / "ref_out" / results_name)});
         } else {
 
-            taco_wrapper::generate_taco_kernel(tskernel, taco_kernel_file, {(taco_kernel_file / "results.tns")});
+            taco_wrapper::generate_taco_kernel(tskernel, taco_kernel_file, {(taco_kernel_file / results_name)});
         }
-        fs::remove(p);
     }
     
     return true;
@@ -41,6 +52,10 @@ bool TacoBackend::compare_results(const string& refDir, const string& testDir) {
     return taco_wrapper::compare_outputs(refDir, testDir);
 }
 
+bool TacoBackend::compare_results(const ReferenceOutput& ref, const string& testDir) {
+    return taco_wrapper::compare_outputs(ref, testDir);
+}
+
 // Plugin entry points
 extern "C" FuzzBackend* create_backend() {
     return new TacoBackend();
@@ -49,3 +64,13 @@ extern "C" FuzzBackend* create_backend() {
 extern "C" void destroy_backend(FuzzBackend* backend) {
     delete backend;
 }
+
+// Every kernel is compiled and run in its own process, so one instance can serve all workers
+extern "C" bool backend_thread_safe() {
+    return true;
+}
+
+// Kernels with a schedule are compiled from the scheduled index statement
+extern "C" bool backend_supports_schedules() {
+    return true;
+}
@@ -0,0 +1,725 @@
+#include "tensure/comparator.hpp"
+#include "tensure/tensor_io.hpp"
+#include "tensure/rng.hpp"
+
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TENSURE_X86_SIMD 1
+#endif
+
+namespace {
+
+const size_t MAX_TOKENS = 64;
+
+// Flat comparison bounds: the box is allocated once per compared file
+const uint64_t MAX_DENSE_VOLUME = 1ull << 22;   // 32 MB of doubles
+const uint64_t SMALL_DENSE_VOLUME = 4096;       // always flat below this
+const uint64_t NEAR_DENSE_FACTOR = 4;           // flat when at least 1/4 of the box is nonzero
+
+const uint64_t FINGERPRINT_SEED = 0x9E3779B97F4A7C15ULL;
+const double MAX_GRID_STEPS = 9.0e18;           // rounded values must fit in an int64
+
+atomic<uint64_t> g_comparisons{0};
+atomic<uint64_t> g_fingerprint_hits{0};
+atomic<uint64_t> g_fingerprint_misses{0};
+atomic<uint64_t> g_sampled{0};
+atomic<uint64_t> g_escalated{0};
+
+enum class TextFormat { TNS, TTX, MTX };
+
+bool has_extension(const string& path, const char* ext)
+{
+    size_t n = strlen(ext);
+    return path.size() >= n && path.compare(path.size() - n, n, ext) == 0;
+}
+
+inline bool is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Parse one data line of a text tensor file. Returns false for lines without an entry.
+bool parse_line(const char* p, const char* end, TextFormat format, int64_t* coords, size_t& rank, double& value)
+{
+    const char* tok_begin[MAX_TOKENS];
+    const char* tok_end[MAX_TOKENS];
+    size_t n = 0;
+    while (p < end && n < MAX_TOKENS)
+    {
+        while (p < end && is_blank(*p)) p++;
+        if (p == end) break;
+        tok_begin[n] = p;
+        while (p < end && !is_blank(*p)) p++;
+        tok_end[n++] = p;
+    }
+
+    // .mtx: "i j value" (pattern matrices have no value and are skipped); .tns/.ttx: coordinates then value
+    if (format == TextFormat::MTX)
+    {
+        if (n < 3) return false;
+        n = 3;
+    }
+    if (n < 2) return false;
+
+    const char* v = tok_begin[n - 1];
+    if (*v == '+') v++;
+    if (from_chars(v, tok_end[n - 1], value).ec != errc())
+        return false;
+
+    rank = n - 1;
+    for (size_t d = 0; d < rank; d++)
+    {
+        // Like stoi: "3.0" reads as 3
+        const char* c = tok_begin[d];
+        if (*c == '+') c++;
+        if (from_chars(c, tok_end[d], coords[d]).ec != errc())
+            return false;
+    }
+    return true;
+}
+
+bool for_each_text_entry(const string& path, TextFormat format, const OutputEntryFn& fn)
+{
+    MappedFile file(path);
+    const char* p = file.data();
+    const char* end = p + file.size();
+    int64_t coords[MAX_TOKENS];
+    size_t rank;
+    double value;
+
+    // .ttx starts with a line of dimensions, .mtx with "rows cols nnz" (after the comments)
+    bool skip_header = format != TextFormat::TNS;
+    while (p < end)
+    {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        const char* line_end = nl ? nl : end;
+        const char* line = p;
+        p = nl ? nl + 1 : end;
+
+        while (line < line_end && is_blank(*line)) line++;
+        if (line == line_end || *line == '%' || *line == '#') continue;
+        if (skip_header)
+        {
+            skip_header = false;
+            continue;
+        }
+
+        if (!parse_line(line, line_end, format, coords, rank, value) || value == 0.0)
+            continue; // zeros and garbage lines carry no entry
+        if (!fn(coords, rank, value))
+            return false;
+    }
+    return true;
+}
+
+// Start of the entries of a text file: after the comments and, for .ttx/.mtx, the header line
+size_t text_data_start(const char* data, size_t size, TextFormat format)
+{
+    bool skip_header = format != TextFormat::TNS;
+    const char* p = data;
+    const char* end = data + size;
+    while (p < end)
+    {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        const char* line = p;
+        while (line < (nl ? nl : end) && is_blank(*line)) line++;
+        bool is_entry = line != (nl ? nl : end) && *line != '%' && *line != '#';
+        if (is_entry && !skip_header)
+            break;
+        if (is_entry)
+            skip_header = false;
+        p = nl ? nl + 1 : end;
+    }
+    return p - data;
+}
+
+// Random access to the entries of an output file: a uniform entry of a .tsb file, or a uniform
+// line of a text file. The line under a uniform byte offset is kept with probability
+// min_line_ / its length, so that long lines are not drawn more often than short ones.
+class EntrySampler {
+public:
+    explicit EntrySampler(const string& path)
+    {
+        if (has_extension(path, ".tsb"))
+        {
+            binary_ = make_unique<MappedTensorFile>(path);
+            return;
+        }
+        format_ = has_extension(path, ".mtx") ? TextFormat::MTX : has_extension(path, ".ttx") ? TextFormat::TTX : TextFormat::TNS;
+        if (format_ == TextFormat::TNS && !has_extension(path, ".tns"))
+            throw runtime_error("Unsupported tensor format: " + path);
+        text_ = make_unique<MappedFile>(path);
+        data_start_ = text_data_start(text_->data(), text_->size(), format_);
+
+        // Shortest entry line (newline included), in one memchr pass
+        const char* data = text_->data();
+        const char* end = data + text_->size();
+        for (const char* line = data + data_start_; line < end;)
+        {
+            const char* nl = static_cast<const char*>(memchr(line, '\n', end - line));
+            const char* next = nl ? nl + 1 : end;
+            const char* p = line;
+            while (p < next && is_blank(*p)) p++;
+            if (p < next && *p != '\n' && *p != '%' && *p != '#')
+                min_line_ = min<size_t>(min_line_, next - line);
+            line = next;
+        }
+    }
+
+    bool empty() const { return binary_ ? binary_->nnz() == 0 : data_start_ >= text_->size(); }
+
+    // Draw one entry; false when the position holds none (a zero, a comment or a garbage line)
+    bool draw(tsRng& gen, int64_t* coords, size_t& rank, double& value)
+    {
+        if (binary_)
+        {
+            uint64_t n = uniform_int_distribution<uint64_t>(0, binary_->nnz() - 1)(gen);
+            rank = binary_->rank();
+            for (size_t d = 0; d < rank; d++)
+                coords[d] = binary_->coords(d)[n];
+            value = binary_->values()[n];
+            return value != 0.0;
+        }
+
+        const char* data = text_->data();
+        const char* end = data + text_->size();
+        uniform_int_distribution<size_t> offset_dist(data_start_, text_->size() - 1);
+        const char* line;
+        const char* line_end;
+        size_t length;
+        do {
+            line = data + offset_dist(gen);
+            while (line > data + data_start_ && line[-1] != '\n') line--;
+            const char* nl = static_cast<const char*>(memchr(line, '\n', end - line));
+            line_end = nl ? nl : end;
+            length = (nl ? nl + 1 : end) - line;
+        } while (!bernoulli_distribution(min(1.0, double(min_line_) / length))(gen));
+        while (line < line_end && is_blank(*line)) line++;
+        if (line == line_end || *line == '%' || *line == '#')
+            return false;
+        return parse_line(line, line_end, format_, coords, rank, value) && value != 0.0;
+    }
+
+private:
+    unique_ptr<MappedTensorFile> binary_;
+    unique_ptr<MappedFile> text_;
+    TextFormat format_ = TextFormat::TNS;
+    size_t data_start_ = 0;
+    size_t min_line_ = SIZE_MAX;
+};
+
+inline bool value_matches(double ref, double out, double tol, double rel_tol)
+{
+    return fabs(ref - out) <= tol + rel_tol * fabs(ref) && (ref == 0.0) == (out == 0.0);
+}
+
+bool dense_match_scalar(const double* ref, const double* out, size_t n, double tol, double rel_tol)
+{
+    for (size_t i = 0; i < n; i++)
+        if (!value_matches(ref[i], out[i], tol, rel_tol))
+            return false;
+    return true;
+}
+
+#ifdef TENSURE_X86_SIMD
+__attribute__((target("avx2")))
+bool dense_match_avx2(const double* ref, const double* out, size_t n, double tol, double rel_tol)
+{
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d vtol = _mm256_set1_pd(tol);
+    const __m256d vrel = _mm256_set1_pd(rel_tol);
+    const __m256d zero = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d a = _mm256_loadu_pd(ref + i);
+        __m256d b = _mm256_loadu_pd(out + i);
+        __m256d diff = _mm256_andnot_pd(sign, _mm256_sub_pd(a, b));
+        __m256d bound = _mm256_add_pd(vtol, _mm256_mul_pd(vrel, _mm256_andnot_pd(sign, a)));
+        // NaN compares false, so it never matches
+        __m256d ok = _mm256_cmp_pd(diff, bound, _CMP_LE_OQ);
+        __m256d zeros_differ = _mm256_xor_pd(_mm256_cmp_pd(a, zero, _CMP_EQ_OQ), _mm256_cmp_pd(b, zero, _CMP_EQ_OQ));
+        if (_mm256_movemask_pd(_mm256_andnot_pd(zeros_differ, ok)) != 0xF)
+            return false;
+    }
+    return dense_match_scalar(ref + i, out + i, n - i, tol, rel_tol);
+}
+
+__attribute__((target("avx512f")))
+bool dense_match_avx512(const double* ref, const double* out, size_t n, double tol, double rel_tol)
+{
+    const __m512d vtol = _mm512_set1_pd(tol);
+    const __m512d vrel = _mm512_set1_pd(rel_tol);
+    const __m512d zero = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m512d a = _mm512_loadu_pd(ref + i);
+        __m512d b = _mm512_loadu_pd(out + i);
+        __m512d diff = _mm512_abs_pd(_mm512_sub_pd(a, b));
+        __m512d bound = _mm512_add_pd(vtol, _mm512_mul_pd(vrel, _mm512_abs_pd(a)));
+        __mmask8 ok = _mm512_cmp_pd_mask(diff, bound, _CMP_LE_OQ);
+        __mmask8 zeros_differ = _mm512_cmp_pd_mask(a, zero, _CMP_EQ_OQ) ^ _mm512_cmp_pd_mask(b, zero, _CMP_EQ_OQ);
+        if ((ok & ~zeros_differ & 0xFF) != 0xFF)
+            return false;
+    }
+    return dense_match_scalar(ref + i, out + i, n - i, tol, rel_tol);
+}
+#endif
+
+typedef bool (*DenseMatchFn)(const double*, const double*, size_t, double, double);
+
+typedef struct DenseMatchImpl {
+    DenseMatchFn fn;
+    const char* isa;
+} DenseMatchImpl;
+
+const DenseMatchImpl& dense_match_impl()
+{
+    static const DenseMatchImpl impl = [] {
+#ifdef TENSURE_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return DenseMatchImpl{dense_match_avx512, "avx512"};
+        if (__builtin_cpu_supports("avx2"))
+            return DenseMatchImpl{dense_match_avx2, "avx2"};
+#endif
+        return DenseMatchImpl{dense_match_scalar, "scalar"};
+    }();
+    return impl;
+}
+
+bool for_each_binary_entry(const string& path, const OutputEntryFn& fn)
+{
+    MappedTensorFile file(path);
+    size_t rank = file.rank();
+    vector<int64_t> coords(rank);
+    for (uint64_t n = 0; n < file.nnz(); n++)
+    {
+        double value = file.values()[n];
+        if (value == 0.0) continue;
+        for (size_t d = 0; d < rank; d++)
+            coords[d] = file.coords(d)[n];
+        if (!fn(coords.data(), rank, value))
+            return false;
+    }
+    return true;
+}
+
+}
+
+bool for_each_output_entry(const string& path, const OutputEntryFn& fn)
+{
+    if (has_extension(path, ".tsb"))
+        return for_each_binary_entry(path, fn);
+    if (has_extension(path, ".tns"))
+        return for_each_text_entry(path, TextFormat::TNS, fn);
+    if (has_extension(path, ".ttx"))
+        return for_each_text_entry(path, TextFormat::TTX, fn);
+    if (has_extension(path, ".mtx"))
+        return for_each_text_entry(path, TextFormat::MTX, fn);
+    throw runtime_error("Unsupported tensor format: " + path);
+}
+
+bool dense_values_match(const double* ref, const double* out, size_t n, double tol, double rel_tol)
+{
+    return dense_match_impl().fn(ref, out, n, tol, rel_tol);
+}
+
+const char* dense_compare_isa()
+{
+    return dense_match_impl().isa;
+}
+
+void OutputFingerprint::add(const int64_t* coords, double value)
+{
+    if (value == 0.0) return;
+    double steps = value / grid;
+    if (!(fabs(steps) < MAX_GRID_STEPS))
+    {
+        valid = false;
+        return;
+    }
+    uint64_t h = FINGERPRINT_SEED;
+    for (size_t d = 0; d < rank; d++)
+    {
+        h = mix64(h ^ static_cast<uint64_t>(coords[d]));
+        coord_sums[d] += static_cast<uint64_t>(coords[d]);
+    }
+    h = mix64(h ^ static_cast<uint64_t>(llround(steps)));
+    value_hash += h;
+    nnz++;
+}
+
+bool OutputFingerprint::operator==(const OutputFingerprint& other) const
+{
+    return valid && other.valid && grid == other.grid && rank == other.rank && nnz == other.nnz &&
+           value_hash == other.value_hash && coord_sums == other.coord_sums;
+}
+
+bool OutputFingerprint::save(const string& file) const
+{
+    if (!valid) return false;
+    FILE* f = fopen(file.c_str(), "w");
+    if (!f) return false;
+    fprintf(f, "TSFP1 %.17g %zu %llu %llu", grid, rank, static_cast<unsigned long long>(nnz), static_cast<unsigned long long>(value_hash));
+    for (uint64_t sum : coord_sums)
+        fprintf(f, " %llu", static_cast<unsigned long long>(sum));
+    fprintf(f, "\n");
+    return fclose(f) == 0;
+}
+
+bool OutputFingerprint::load(const string& file, OutputFingerprint& fp)
+{
+    error_code ec;
+    if (!filesystem::is_regular_file(file, ec) || filesystem::file_size(file, ec) == 0)
+        return false;
+    MappedFile mapped(file);
+    const char* p = mapped.data();
+    const char* end = p + mapped.size();
+
+    auto skip_blanks = [&] { while (p < end && (is_blank(*p) || *p == '\n')) p++; };
+    auto next = [&](auto& value) {
+        skip_blanks();
+        auto res = from_chars(p, end, value);
+        p = res.ptr;
+        return res.ec == errc();
+    };
+
+    if (mapped.size() < 6 || memcmp(p, "TSFP1 ", 6) != 0)
+        return false;
+    p += 6;
+    OutputFingerprint parsed;
+    if (!next(parsed.grid) || !next(parsed.rank) || !next(parsed.nnz) || !next(parsed.value_hash))
+        return false;
+    parsed.coord_sums.resize(parsed.rank);
+    for (uint64_t& sum : parsed.coord_sums)
+        if (!next(sum))
+            return false;
+    fp = parsed;
+    return true;
+}
+
+string fingerprint_file(const string& output_file)
+{
+    return filesystem::path(output_file).replace_extension(".fp").string();
+}
+
+OutputFingerprint fingerprint_output(const string& path, size_t rank, double grid)
+{
+    OutputFingerprint fp(rank);
+    fp.grid = grid;
+    for_each_output_entry(path, [&](const int64_t* coords, size_t entry_rank, double value) {
+        if (entry_rank != rank)
+            throw runtime_error("Entries of different rank in " + path);
+        fp.add(coords, value);
+        return true;
+    });
+    return fp;
+}
+
+CompareStats compare_stats()
+{
+    return CompareStats{g_comparisons.load(), g_fingerprint_hits.load(), g_fingerprint_misses.load(), g_sampled.load(), g_escalated.load()};
+}
+
+uint64_t sample_size(const SampleOptions& opts)
+{
+    if (opts.error_rate <= 0.0 || opts.error_rate >= 1.0 || opts.confidence <= 0.0 || opts.confidence >= 1.0)
+        throw invalid_argument("Sampling needs 0 < confidence, error_rate < 1");
+    return static_cast<uint64_t>(ceil(log1p(-opts.confidence) / log1p(-opts.error_rate)));
+}
+
+uint64_t output_entry_bound(const string& path)
+{
+    if (has_extension(path, ".tsb"))
+        return MappedTensorFile(path).nnz();
+
+    MappedFile file(path);
+    uint64_t lines = 0;
+    const char* p = file.data();
+    const char* end = p + file.size();
+    while (p < end)
+    {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        lines++;
+        p = nl ? nl + 1 : end;
+    }
+    return lines;
+}
+
+// The hash agrees with the test vector shared with the other writers (see FINGERPRINT_TEST_HASH)
+static bool fingerprint_hash_ok()
+{
+    static const bool ok = [] {
+        OutputFingerprint fp(2);
+        const int64_t first[2] = {0, 1}, second[2] = {2, 3};
+        fp.add(first, 1.5);
+        fp.add(second, -0.25);
+        return fp.value_hash == FINGERPRINT_TEST_HASH;
+    }();
+    return ok;
+}
+
+ReferenceOutput::ReferenceOutput(const string& path, bool dense_output) : path_(path), dense_output_(dense_output)
+{
+    has_fingerprint_ = fingerprint_hash_ok() && OutputFingerprint::load(fingerprint_file(path), fingerprint_);
+}
+
+void ReferenceOutput::enable_sampling(const SampleOptions& opts, uint64_t seed)
+{
+    sample_size(opts); // validate
+    sampling_ = opts.min_nnz > 0;
+    sample_opts_ = opts;
+    sample_seed_ = seed;
+}
+
+void ReferenceOutput::load() const
+{
+    call_once(loaded_, [this] { const_cast<ReferenceOutput*>(this)->load_entries(); });
+}
+
+void ReferenceOutput::load_entries()
+{
+    const string& path = path_;
+    bool first = true;
+    for_each_output_entry(path, [&](const int64_t* coords, size_t rank, double value) {
+        if (first)
+        {
+            rank_ = rank;
+            lower_.assign(coords, coords + rank);
+            first = false;
+        }
+        if (rank != rank_)
+            throw runtime_error("Entries of different rank in " + path);
+        coords_.insert(coords_.end(), coords, coords + rank);
+        values_.push_back(value);
+        return true;
+    });
+
+    // Bounding box, and whether positions inside it fit in 64 bits
+    size_t nnz = values_.size();
+    vector<int64_t> upper = lower_;
+    for (size_t n = 0; n < nnz; n++)
+    {
+        for (size_t d = 0; d < rank_; d++)
+        {
+            lower_[d] = min(lower_[d], coords_[n * rank_ + d]);
+            upper[d] = max(upper[d], coords_[n * rank_ + d]);
+        }
+    }
+    extent_.resize(rank_);
+    uint64_t volume = 1;
+    for (size_t d = 0; d < rank_; d++)
+    {
+        extent_[d] = static_cast<uint64_t>(upper[d] - lower_[d]) + 1;
+        if (__builtin_mul_overflow(volume, extent_[d], &volume))
+            linear_keys_ = false;
+    }
+
+    if (linear_keys_ && nnz > 0 && volume <= MAX_DENSE_VOLUME &&
+        (dense_output_ || volume <= SMALL_DENSE_VOLUME || volume <= NEAR_DENSE_FACTOR * nnz))
+    {
+        // Duplicated coordinates keep their first value, as in the indexed comparison
+        dense_.assign(volume, 0.0);
+        unique_nnz_ = 0;
+        for (size_t n = 0; n < nnz; n++)
+        {
+            uint64_t key;
+            make_key(&coords_[n * rank_], key);
+            if (dense_[key] != 0.0) continue;
+            dense_[key] = values_[n];
+            unique_nnz_++;
+        }
+        coords_ = vector<int64_t>();
+        values_ = vector<double>();
+        return;
+    }
+
+    size_t capacity = 16;
+    while (capacity < 2 * nnz) capacity *= 2;
+    slots_.assign(capacity, 0);
+    slot_keys_.assign(capacity, 0);
+
+    // Duplicated coordinates keep their first value, as the entries are matched once
+    unique_nnz_ = 0;
+    for (size_t n = 0; n < nnz; n++)
+    {
+        const int64_t* c = &coords_[n * rank_];
+        uint64_t key;
+        make_key(c, key);
+        if (find(c) >= 0) continue;
+        size_t mask = slots_.size() - 1;
+        size_t s = mix64(key) & mask;
+        while (slots_[s] != 0) s = (s + 1) & mask;
+        slots_[s] = static_cast<uint32_t>(n + 1);
+        slot_keys_[s] = key;
+        unique_nnz_++;
+    }
+}
+
+bool ReferenceOutput::make_key(const int64_t* coords, uint64_t& key) const
+{
+    if (!linear_keys_)
+    {
+        key = 0;
+        for (size_t d = 0; d < rank_; d++)
+            key = mix64(key ^ static_cast<uint64_t>(coords[d])) + d;
+        return true;
+    }
+    key = 0;
+    for (size_t d = 0; d < rank_; d++)
+    {
+        if (coords[d] < lower_[d] || static_cast<uint64_t>(coords[d] - lower_[d]) >= extent_[d])
+            return false; // outside the reference's bounding box
+        key = key * extent_[d] + static_cast<uint64_t>(coords[d] - lower_[d]);
+    }
+    return true;
+}
+
+int64_t ReferenceOutput::find(const int64_t* coords) const
+{
+    uint64_t key;
+    if (!make_key(coords, key))
+        return -1;
+    size_t mask = slots_.size() - 1;
+    for (size_t s = mix64(key) & mask; slots_[s] != 0; s = (s + 1) & mask)
+    {
+        if (slot_keys_[s] != key) continue;
+        int64_t n = static_cast<int64_t>(slots_[s]) - 1;
+        if (linear_keys_ || equal(coords, coords + rank_, &coords_[n * rank_]))
+            return n;
+    }
+    return -1;
+}
+
+bool ReferenceOutput::lookup(const int64_t* coords, double& value) const
+{
+    if (!dense_.empty())
+    {
+        uint64_t key;
+        if (!make_key(coords, key) || dense_[key] == 0.0) return false;
+        value = dense_[key];
+        return true;
+    }
+    int64_t n = unique_nnz_ > 0 ? find(coords) : -1;
+    if (n < 0) return false;
+    value = values_[n];
+    return true;
+}
+
+bool ReferenceOutput::sample_matches(const string& kernel_output, const OutputFingerprint* other, double tol, double rel_tol) const
+{
+    // Samples are drawn from the mutant, so they never see reference nonzeros it dropped: check the
+    // counts first, exactly from the fingerprints, or else against the mutant's entry bound
+    if (other && (other->rank != fingerprint_.rank || other->nnz != fingerprint_.nnz))
+        return false;
+    if (!other && output_entry_bound(kernel_output) < unique_nnz_)
+        return false;
+
+    EntrySampler sampler(kernel_output);
+    if (sampler.empty())
+        return false;
+
+    tsRng gen(sample_seed_, sample_calls_++);
+    uint64_t draws = sample_size(sample_opts_);
+    uint64_t checked = 0;
+    int64_t coords[MAX_TOKENS];
+    size_t rank;
+    double value, ref_value;
+    for (uint64_t i = 0; i < draws; i++)
+    {
+        if (!sampler.draw(gen, coords, rank, value))
+            continue;
+        if (rank != rank_ || !lookup(coords, ref_value) || !value_matches(ref_value, value, tol, rel_tol))
+            return false;
+        checked++;
+    }
+    // Mostly zeros or unreadable lines: the sample says nothing
+    return checked * 2 >= draws;
+}
+
+bool ReferenceOutput::matches(const string& kernel_output, double tol, double rel_tol) const
+{
+    g_comparisons++;
+
+    // Equal fingerprints mean every value is within grid <= tol of the reference
+    OutputFingerprint other;
+    bool has_other = has_fingerprint_ && OutputFingerprint::load(fingerprint_file(kernel_output), other);
+    if (has_other && fingerprint_.grid <= tol && other == fingerprint_)
+    {
+        g_fingerprint_hits++;
+        return true;
+    }
+
+    // Usable fingerprints that differ on matching outputs: a few straddle a rounding boundary,
+    // all of them means the writers' hashes disagree (reported by compare_stats)
+    bool equal = entries_match(kernel_output, has_other ? &other : nullptr, tol, rel_tol);
+    if (equal && has_other && fingerprint_.grid <= tol && other.valid)
+        g_fingerprint_misses++;
+    return equal;
+}
+
+bool ReferenceOutput::entries_match(const string& kernel_output, const OutputFingerprint* other, double tol, double rel_tol) const
+{
+    load();
+
+    if (sampling_ && unique_nnz_ >= sample_opts_.min_nnz && sample_size(sample_opts_) < unique_nnz_)
+    {
+        if (sample_matches(kernel_output, other, tol, rel_tol))
+        {
+            g_sampled++;
+            return true;
+        }
+        g_escalated++;
+    }
+    // Not even enough lines for the reference's nonzeros
+    if (output_entry_bound(kernel_output) < unique_nnz_)
+        return false;
+
+    if (dense())
+    {
+        vector<double> out(dense_.size(), 0.0);
+        bool in_box = for_each_output_entry(kernel_output, [&](const int64_t* coords, size_t rank, double value) {
+            uint64_t key;
+            if (rank != rank_ || !make_key(coords, key)) return false;
+            if (out[key] == 0.0) out[key] = value;
+            return true;
+        });
+        return in_box && dense_values_match(dense_.data(), out.data(), out.size(), tol, rel_tol);
+    }
+
+    vector<bool> seen(values_.size(), false);
+    size_t matched = 0;
+    bool equal = for_each_output_entry(kernel_output, [&](const int64_t* coords, size_t rank, double value) {
+        if (rank != rank_ && unique_nnz_ > 0) return false;
+        int64_t n = unique_nnz_ > 0 ? find(coords) : -1;
+        if (n < 0) return false;                        // nonzero missing from the reference
+        if (seen[n]) return true;
+        seen[n] = true;
+        matched++;
+        return value_matches(values_[n], value, tol, rel_tol);
+    });
+    return equal && matched == unique_nnz_;
+}
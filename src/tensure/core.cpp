@@ -0,0 +1,48 @@
+#include "tensure/core.hpp"
+#include "tensure/random_gen.hpp"
+#include "tensure/utils.hpp"
+
+namespace tensure {
+
+string version()
+{
+    return to_string(TENSURE_CORE_VERSION_MAJOR) + "." + to_string(TENSURE_CORE_VERSION_MINOR);
+}
+
+GeneratedKernel generate_kernel(const fs::path& out_dir, const GenerateOptions& options)
+{
+    fs::path data_dir = out_dir / "data";
+    fs::create_directories(data_dir);
+
+    // Structure and data use separate streams, as in a fuzzing job
+    tsRng einsum_gen = options.seed ? tsRng(options.seed, static_cast<uint64_t>(RngStage::EINSUM)) : tsRng(thread_rng()(), 0);
+    tsRng data_gen = options.seed ? tsRng(options.seed, static_cast<uint64_t>(RngStage::TENSOR_DATA)) : tsRng(thread_rng()(), 1);
+
+    GeneratedKernel result;
+    auto [tensors, einsum] = generate_random_einsum(options.num_inputs, options.max_rank, einsum_gen);
+    result.einsum = einsum;
+
+    result.data_files = generate_random_tensor_data(tensors, data_dir.string(), "", options.tensor_file_format, data_gen, options.sparsity_pattern);
+    if (result.data_files.size() != tensors.size() - 1)
+        throw runtime_error("Tensor data generation failed in " + data_dir.string());
+
+    result.kernel_file = out_dir / "kernel.json";
+    if (!generate_ref_kernel(tensors, {einsum}, result.data_files, result.kernel_file.string()))
+        throw runtime_error("Reference kernel generation failed in " + out_dir.string());
+
+    result.kernel.loadJson(result.kernel_file.string());
+    return result;
+}
+
+vector<string> mutate_kernel(const fs::path& out_dir, const string& kernel_file, int max_mutants, uint64_t seed)
+{
+    tsRng gen = seed ? tsRng(seed, static_cast<uint64_t>(RngStage::MUTATION)) : tsRng(thread_rng()(), 0);
+    return mutate_equivalent_kernel(out_dir, kernel_file, gen, max_mutants);
+}
+
+bool compare(const string& ref_output, const string& kernel_output, double tol)
+{
+    return compare_outputs(ref_output, kernel_output, tol);
+}
+
+}
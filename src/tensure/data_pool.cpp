@@ -0,0 +1,199 @@
+#include "tensure/data_pool.hpp"
+#include "tensure/patterns.hpp"
+#include "tensure/tensor_io.hpp"
+#include "tensure/utils.hpp"
+#include "tensure/logger.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+// More pending refreshes would only regenerate the same few profiles
+static const size_t MAX_PENDING_REFRESH = 64;
+
+PooledTensorFile::~PooledTensorFile()
+{
+    // An unfinished background write still owns the file
+    if (written.valid())
+        written.wait();
+    error_code ec;
+    fs::remove(file, ec);
+}
+
+bool link_or_copy_file(const fs::path& file, const fs::path& link)
+{
+    error_code ec;
+    fs::remove(link, ec);
+    fs::create_hard_link(file, link, ec);
+    if (!ec)
+        return true;
+    ec.clear();
+    fs::copy_file(file, link, fs::copy_options::overwrite_existing, ec);
+    return !ec;
+}
+
+TensorDataPool::TensorDataPool(const fs::path& dir, size_t capacity_bytes, double reuse_prob, size_t refresh_threads, uint64_t seed)
+    : dir_(dir), capacity_bytes_(capacity_bytes), reuse_prob_(reuse_prob), refresh_gen_(seed, static_cast<uint64_t>(RngStage::DATA_POOL))
+{
+    fs::create_directories(dir_);
+    for (size_t t = 0; t < refresh_threads; t++)
+        workers_.emplace_back(&TensorDataPool::refresh_loop, this);
+}
+
+TensorDataPool::~TensorDataPool()
+{
+    {
+        lock_guard<mutex> lock(mtx_);
+        stopping_ = true;
+        refresh_queue_.clear();
+    }
+    cv_.notify_all();
+    for (auto& w : workers_)
+        w.join();
+
+    order_.clear();
+    entries_.clear();
+    error_code ec;
+    fs::remove_all(dir_, ec);
+}
+
+// Every digit of a double, so that e.g. densities 3e-6 and 6e-6 get different keys
+static string exact_string(double value)
+{
+    ostringstream out;
+    out << setprecision(17) << value;
+    return out.str();
+}
+
+string TensorDataPool::profile_key(const Profile& profile)
+{
+    const PatternParams& p = profile.params;
+    return profile.pattern + "|" + exact_string(p.density) + "|" + exact_string(p.value_min) + "|" + exact_string(p.value_max) + "|" + profile.tfmt + "|" + join(profile.shape, "x");
+}
+
+shared_ptr<PooledTensorFile> TensorDataPool::generate(const Profile& profile, uint64_t seed, bool background)
+{
+    tsTensor tensor;
+    tensor.name = 'P';
+    tensor.shape = profile.shape;
+    tensor.sparsityPattern = profile.pattern;
+    tensor.density = profile.params.density;
+
+    auto data = make_shared<tsTensorData>();
+    data->tfmt = profile.tfmt;
+    fill_pattern_tensor_data(tensor, *data, profile.pattern, seed, profile.params);
+
+    auto entry = make_shared<PooledTensorFile>();
+    entry->shape = profile.shape;
+    entry->pattern = profile.pattern;
+    entry->params = profile.params;
+    entry->tfmt = profile.tfmt;
+    entry->seed = seed;
+    entry->bytes = data->coordinate.size() * sizeof(int) + data->data.size() * sizeof(double);
+    {
+        lock_guard<mutex> lock(mtx_);
+        entry->file = dir_ / ("pool_" + to_string(next_file_++) + "." + profile.tfmt);
+    }
+
+    if (background)
+    {
+        // Refresh threads write the file themselves; the entry is only published once it is complete
+        promise<bool> done;
+        done.set_value(save_tensor_data(profile.shape, *data, entry->file.string(), profile.tfmt));
+        entry->written = done.get_future().share();
+    } else {
+        entry->written = tensor_writer().submit(profile.shape, data, entry->file.string(), profile.tfmt).share();
+    }
+    return entry;
+}
+
+void TensorDataPool::insert(const string& key, shared_ptr<PooledTensorFile> entry)
+{
+    // Released after the lock: the last reference to an entry waits for its write and deletes its file
+    vector<shared_ptr<PooledTensorFile>> evicted;
+    {
+        lock_guard<mutex> lock(mtx_);
+        bytes_ += entry->bytes;
+        entries_[key].push_back(entry);
+        order_.emplace_back(key, entry);
+
+        // Oldest first; the newest entry always stays, even if it alone exceeds the capacity
+        while (bytes_ > capacity_bytes_ && order_.size() > 1)
+        {
+            auto [old_key, old_entry] = std::move(order_.front());
+            order_.pop_front();
+            bytes_ -= old_entry->bytes;
+            auto& list = entries_[old_key];
+            list.erase(find(list.begin(), list.end(), old_entry));
+            if (list.empty())
+                entries_.erase(old_key);
+            evicted.push_back(std::move(old_entry));
+        }
+    }
+}
+
+shared_ptr<const PooledTensorFile> TensorDataPool::acquire(const vector<int>& shape, const string& pattern, const PatternParams& params, const string& tfmt, uint64_t seed, tsRng& gen)
+{
+    Profile profile{shape, pattern, params, tfmt};
+    string key = profile_key(profile);
+    {
+        lock_guard<mutex> lock(mtx_);
+        auto it = entries_.find(key);
+        if (it != entries_.end() && bernoulli_distribution(reuse_prob_)(gen))
+        {
+            auto& list = it->second;
+            shared_ptr<PooledTensorFile> entry = list[uniform_int_distribution<size_t>(0, list.size() - 1)(gen)];
+            hits_++;
+            if (!workers_.empty() && refresh_queue_.size() < MAX_PENDING_REFRESH)
+            {
+                refresh_queue_.push_back(profile);
+                cv_.notify_one();
+            }
+            return entry;
+        }
+    }
+
+    misses_++;
+    shared_ptr<PooledTensorFile> entry = generate(profile, seed, false);
+    insert(key, entry);
+    return entry;
+}
+
+void TensorDataPool::refresh_loop()
+{
+    while (true)
+    {
+        Profile profile;
+        uint64_t seed;
+        {
+            unique_lock<mutex> lock(mtx_);
+            cv_.wait(lock, [this] { return stopping_ || !refresh_queue_.empty(); });
+            if (stopping_)
+                return;
+            profile = std::move(refresh_queue_.front());
+            refresh_queue_.pop_front();
+            seed = refresh_gen_();
+        }
+
+        try {
+            shared_ptr<PooledTensorFile> entry = generate(profile, seed, true);
+            if (entry->written.get())
+                insert(profile_key(profile), entry);
+            else
+                LOG_WARN("Data pool refresh could not write " + entry->file.string());
+        } catch (const exception& e) {
+            LOG_WARN(string("Data pool refresh failed: ") + e.what());
+        }
+    }
+}
+
+size_t TensorDataPool::size()
+{
+    lock_guard<mutex> lock(mtx_);
+    return order_.size();
+}
+
+size_t TensorDataPool::bytes()
+{
+    lock_guard<mutex> lock(mtx_);
+    return bytes_;
+}
@@ -0,0 +1,372 @@
+#include "tensure/dataset.hpp"
+#include "tensure/random_gen.hpp"
+#include "tensure/utils.hpp"
+
+#include <charconv>
+#include <thread>
+
+namespace {
+
+typedef struct ParsedChunk {
+    vector<int> coordinate;
+    vector<double> values;
+    vector<int> max_coord;
+    string error;
+} ParsedChunk;
+
+const char* skip_blanks(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    return p;
+}
+
+const char* next_line(const char* p, const char* end)
+{
+    const void* nl = memchr(p, '\n', end - p);
+    return nl ? static_cast<const char*>(nl) + 1 : end;
+}
+
+// Parse "c0 c1 ... [value]" lines (1-based coordinates) of [begin, end)
+void parse_entries(const char* begin, const char* end, size_t rank, bool has_value, char comment, ParsedChunk& out)
+{
+    out.max_coord.assign(rank, 0);
+    vector<int> coord(rank);
+    for (const char* line = begin; line < end; line = next_line(line, end))
+    {
+        const char* p = skip_blanks(line, end);
+        if (p == end || *p == '\n' || *p == comment)
+            continue;
+
+        for (size_t d = 0; d < rank; d++)
+        {
+            p = skip_blanks(p, end);
+            auto [ptr, ec] = from_chars(p, end, coord[d]);
+            if (ec != errc() || coord[d] < 1)
+            {
+                out.error = "bad coordinate in line: " + string(line, next_line(line, end) - line);
+                return;
+            }
+            p = ptr;
+            out.max_coord[d] = max(out.max_coord[d], coord[d]);
+            coord[d] -= 1;
+        }
+
+        double value = 1.0;
+        if (has_value)
+        {
+            p = skip_blanks(p, end);
+            if (p < end && *p == '+') p++;
+            auto [ptr, ec] = from_chars(p, end, value);
+            if (ec != errc())
+            {
+                out.error = "bad value in line: " + string(line, next_line(line, end) - line);
+                return;
+            }
+        }
+        out.coordinate.insert(out.coordinate.end(), coord.begin(), coord.end());
+        out.values.push_back(value);
+    }
+}
+
+// Split [begin, end) at line boundaries and parse the pieces in parallel
+vector<ParsedChunk> parse_parallel(const char* begin, const char* end, size_t rank, bool has_value, char comment, size_t num_threads)
+{
+    if (num_threads == 0)
+        num_threads = max(1u, thread::hardware_concurrency());
+    // Not worth a thread below ~1 MB
+    num_threads = max<size_t>(1, min(num_threads, static_cast<size_t>(end - begin) >> 20));
+
+    vector<const char*> bounds = {begin};
+    for (size_t t = 1; t < num_threads; t++)
+    {
+        const char* cut = begin + (end - begin) * t / num_threads;
+        bounds.push_back(max(bounds.back(), next_line(cut, end)));
+    }
+    bounds.push_back(end);
+
+    vector<ParsedChunk> chunks(num_threads);
+    vector<thread> workers;
+    for (size_t t = 1; t < num_threads; t++)
+        workers.emplace_back(parse_entries, bounds[t], bounds[t + 1], rank, has_value, comment, ref(chunks[t]));
+    parse_entries(bounds[0], bounds[1], rank, has_value, comment, chunks[0]);
+    for (auto& w : workers)
+        w.join();
+
+    for (const auto& chunk : chunks)
+    {
+        if (!chunk.error.empty())
+            throw runtime_error(chunk.error);
+    }
+    return chunks;
+}
+
+void gather(vector<ParsedChunk>& chunks, DatasetTensor& tensor)
+{
+    size_t nnz = 0;
+    for (const auto& chunk : chunks)
+        nnz += chunk.values.size();
+    tensor.data.invalidate_index();
+    tensor.data.reserve(nnz);
+    for (auto& chunk : chunks)
+    {
+        tensor.data.coordinate.insert(tensor.data.coordinate.end(), chunk.coordinate.begin(), chunk.coordinate.end());
+        tensor.data.data.insert(tensor.data.data.end(), chunk.values.begin(), chunk.values.end());
+        chunk = ParsedChunk();
+    }
+}
+
+void load_mtx(const MappedFile& file, DatasetTensor& tensor, size_t num_threads)
+{
+    const char* p = file.data();
+    const char* end = p + file.size();
+
+    // %%MatrixMarket matrix coordinate <field> <symmetry>
+    const char* header_end = next_line(p, end);
+    string header(p, header_end);
+    transform(header.begin(), header.end(), header.begin(), ::tolower);
+    istringstream hs(header);
+    string banner, object, layout, field = "real", symmetry = "general";
+    hs >> banner >> object >> layout >> field >> symmetry;
+    if (banner != "%%matrixmarket" || layout != "coordinate")
+        throw runtime_error("Only MatrixMarket coordinate files are supported: " + tensor.path);
+    if (field == "complex")
+        throw runtime_error("Complex MatrixMarket files are not supported: " + tensor.path);
+
+    // Skip comments, then the size line: d0 d1 ... nnz
+    p = header_end;
+    while (p < end && *skip_blanks(p, end) == '%')
+        p = next_line(p, end);
+    const char* size_end = next_line(p, end);
+    istringstream ss(string(p, size_end));
+    vector<long long> sizes;
+    long long v;
+    while (ss >> v)
+        sizes.push_back(v);
+    if (sizes.size() < 2)
+        throw runtime_error("Missing size line in " + tensor.path);
+
+    size_t rank = sizes.size() - 1;
+    for (size_t d = 0; d < rank; d++)
+        tensor.shape.push_back(static_cast<int>(sizes[d]));
+    tensor.data.rank = rank;
+
+    vector<ParsedChunk> chunks = parse_parallel(size_end, end, rank, field != "pattern", '%', num_threads);
+    gather(chunks, tensor);
+
+    // Symmetric storage keeps one triangle; materialize the other one
+    if (rank == 2 && (symmetry == "symmetric" || symmetry == "skew-symmetric" || symmetry == "hermitian"))
+    {
+        double sign = (symmetry == "skew-symmetric") ? -1.0 : 1.0;
+        size_t stored = tensor.data.size();
+        for (size_t n = 0; n < stored; n++)
+        {
+            const int* c = tensor.data.coord(n);
+            if (c[0] == c[1])
+                continue;
+            int mirrored[2] = {c[1], c[0]};
+            tensor.data.append(mirrored, sign * tensor.data.data[n]);
+        }
+    }
+}
+
+void load_tns(const MappedFile& file, DatasetTensor& tensor, size_t num_threads)
+{
+    const char* p = file.data();
+    const char* end = p + file.size();
+
+    // The rank is the number of columns of the first entry minus the value
+    const char* line = p;
+    while (line < end && (*skip_blanks(line, end) == '#' || *skip_blanks(line, end) == '\n'))
+        line = next_line(line, end);
+    if (line == end)
+        throw runtime_error("No entries in " + tensor.path);
+    istringstream ls(string(line, next_line(line, end)));
+    size_t columns = 0;
+    string tok;
+    while (ls >> tok)
+        columns++;
+    if (columns < 2)
+        throw runtime_error("Malformed entry in " + tensor.path);
+
+    size_t rank = columns - 1;
+    tensor.data.rank = rank;
+    vector<ParsedChunk> chunks = parse_parallel(line, end, rank, true, '#', num_threads);
+
+    tensor.shape.assign(rank, 0);
+    for (const auto& chunk : chunks)
+    {
+        for (size_t d = 0; d < rank; d++)
+            tensor.shape[d] = max(tensor.shape[d], chunk.max_coord[d]);
+    }
+    gather(chunks, tensor);
+}
+
+void load_tsb(const string& path, DatasetTensor& tensor)
+{
+    MappedTensorFile file(path);
+    size_t rank = file.rank();
+    tensor.data.rank = rank;
+    for (size_t d = 0; d < rank; d++)
+        tensor.shape.push_back(static_cast<int>(file.shape(d)));
+
+    tensor.data.invalidate_index();
+    tensor.data.reserve(file.nnz());
+    tensor.data.coordinate.resize(file.nnz() * rank);
+    for (size_t d = 0; d < rank; d++)
+    {
+        const int32_t* coords = file.coords(d);
+        for (uint64_t n = 0; n < file.nnz(); n++)
+            tensor.data.coordinate[n * rank + d] = coords[n] - static_cast<int>(file.index_base());
+    }
+    tensor.data.data.assign(file.values(), file.values() + file.nnz());
+}
+
+}
+
+DatasetTensor load_dataset_tensor(const string& path, size_t num_threads)
+{
+    DatasetTensor tensor;
+    tensor.path = path;
+    tensor.data.tfmt = "tns";
+
+    MappedFile file(path);
+    string ext = fs::path(path).extension().string();
+    if (ext == ".mtx")
+        load_mtx(file, tensor, num_threads);
+    else if (ext == ".tns")
+        load_tns(file, tensor, num_threads);
+    else if (ext == ".tsb")
+        load_tsb(path, tensor);
+    else
+        throw runtime_error("Unsupported dataset file: " + path);
+
+    for (size_t n = 0; n < tensor.data.size(); n++)
+    {
+        const int* c = tensor.data.coord(n);
+        for (size_t d = 0; d < tensor.data.rank; d++)
+        {
+            if (c[d] >= tensor.shape[d])
+                throw runtime_error("Coordinate out of range in " + path);
+        }
+    }
+    return tensor;
+}
+
+DatasetCatalog::DatasetCatalog(const fs::path& dir)
+{
+    for (const auto& entry : fs::recursive_directory_iterator(dir))
+    {
+        string ext = entry.path().extension().string();
+        if (entry.is_regular_file() && (ext == ".mtx" || ext == ".tns" || ext == ".tsb"))
+            files_.push_back(entry.path().string());
+    }
+    sort(files_.begin(), files_.end());
+}
+
+shared_ptr<const DatasetTensor> DatasetCatalog::get(size_t i)
+{
+    const string& path = files_.at(i);
+    {
+        lock_guard<mutex> lock(mtx_);
+        auto it = cache_.find(path);
+        if (it != cache_.end())
+            return it->second;
+    }
+
+    // Parse outside the lock; if two workers race, the first result wins
+    auto tensor = make_shared<const DatasetTensor>(load_dataset_tensor(path));
+    LOG_INFO("Loaded dataset " + path + " (shape " + join(tensor->shape, "x") + ", nnz " + to_string(tensor->data.size()) + ")");
+
+    lock_guard<mutex> lock(mtx_);
+    return cache_.emplace(path, tensor).first->second;
+}
+
+shared_ptr<const DatasetTensor> DatasetCatalog::pick(tsRng& gen)
+{
+    if (files_.empty())
+        return nullptr;
+    size_t i = uniform_int_distribution<size_t>(0, files_.size() - 1)(gen);
+    try {
+        return get(i);
+    } catch (const exception& e) {
+        LOG_WARN("Skipping dataset " + files_[i] + ": " + e.what());
+        return nullptr;
+    }
+}
+
+tuple<vector<tsTensor>, string> generate_dataset_einsum(const DatasetTensor& dataset, int numInputs, tsRng& gen)
+{
+    static const string pool = "ijklmn";
+    size_t rank = dataset.shape.size();
+    if (rank == 0 || rank > pool.size())
+        throw runtime_error("Dataset tensors need 1 to " + to_string(pool.size()) + " modes: " + dataset.path);
+    numInputs = max(numInputs, 2);
+
+    vector<char> dataset_idxs(pool.begin(), pool.begin() + rank);
+    vector<char> fresh_pool(pool.begin() + rank, pool.end());
+    uniform_int_distribution<size_t> dataset_idx_dist(0, rank - 1);
+    bernoulli_distribution coin(0.5);
+
+    // Output keeps at most one dataset index
+    vector<char> outputIdx;
+    if (coin(gen))
+        outputIdx.push_back(dataset_idxs[dataset_idx_dist(gen)]);
+
+    // Every other input: one dataset index plus up to two small fresh indices
+    vector<vector<char>> others(numInputs - 1);
+    set<char> fresh_used;
+    for (auto& idxs : others)
+    {
+        idxs.push_back(dataset_idxs[dataset_idx_dist(gen)]);
+        int num_fresh = fresh_pool.empty() ? 0 : uniform_int_distribution<int>(0, min<int>(2, fresh_pool.size()))(gen);
+        vector<char> candidates = fresh_pool;
+        shuffle(candidates.begin(), candidates.end(), gen);
+        for (int f = 0; f < num_fresh; f++)
+        {
+            idxs.push_back(candidates[f]);
+            fresh_used.insert(candidates[f]);
+        }
+    }
+    for (char c : fresh_used)
+    {
+        if (coin(gen))
+            outputIdx.push_back(c);
+    }
+
+    map<char, int> id_val_map = map_id_to_val(vector<char>(fresh_used.begin(), fresh_used.end()), gen);
+    for (size_t d = 0; d < rank; d++)
+        id_val_map[dataset_idxs[d]] = dataset.shape[d];
+
+    auto make_tsTensor = [&](char name, const vector<char>& idxs, bool is_dataset) {
+        tsTensor tensor;
+        tensor.name = name;
+        tensor.idxs = idxs;
+        tensor.str_repr = string(1, name) + "(" + join(idxs) + ")";
+        for (size_t d = 0; d < idxs.size(); d++)
+        {
+            tensor.shape.push_back(id_val_map[idxs[d]]);
+            tensor.storageFormat.push_back((is_dataset && d > 0) ? tsSparse : random_format(gen));
+        }
+        // Mutants must not store the dataset densely either
+        if (is_dataset)
+            for (size_t d = 1; d < idxs.size(); d++)
+            {
+                tensor.pinned.resize(idxs.size(), false);
+                tensor.pinned[d] = true;
+            }
+        return tensor;
+    };
+
+    vector<tsTensor> tsTensors;
+    tsTensors.push_back(make_tsTensor('A', outputIdx, false));
+    tsTensors.push_back(make_tsTensor('B', dataset_idxs, true));
+    string rhs = tsTensors.back().str_repr;
+    for (size_t i = 0; i < others.size(); i++)
+    {
+        tsTensors.push_back(make_tsTensor('C' + i, others[i], false));
+        rhs += " * " + tsTensors.back().str_repr;
+    }
+
+    return {tsTensors, tsTensors[0].str_repr + " = " + rhs};
+}
@@ -0,0 +1,297 @@
+#include "tensure/mutation_space.hpp"
+#include "tensure/random_gen.hpp"
+
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// --- Helper: Trim whitespace ---
+string trim(const string& str) {
+    size_t first = str.find_first_not_of(" \t");
+    if (string::npos == first) return str;
+    size_t last = str.find_last_not_of(" \t");
+    return str.substr(first, (last - first + 1));
+}
+
+// --- Helper: Extract Tensor Name from "Name(indices)" ---
+string extract_name(const string& term) {
+    size_t paren_pos = term.find('(');
+    if (paren_pos == string::npos) return trim(term);
+    return trim(term.substr(0, paren_pos));
+}
+
+uint64_t factorial(size_t n) {
+    uint64_t f = 1;
+    for (size_t i = 2; i <= n; i++) f *= i;
+    return f;
+}
+
+}
+
+MutationSpace::MutationSpace(const tsKernel& original) : original_(original)
+{
+    // Pinned modes keep their format and get no bit of the format digit
+    for (const auto& t : original_.tensors) {
+        for (size_t d = 0; d < t.storageFormat.size(); d++)
+            modes_ += !t.is_pinned(d);
+        schedulable_ |= !t.idxs.empty();
+    }
+    schedulable_ &= original_.computations.size() == 1;
+
+    // The inputs can be reordered if every term of the product names the input at its position
+    size_t inputs = original_.tensors.empty() ? 0 : original_.tensors.size() - 1;
+    if (original_.computations.size() == 1) {
+        const string& expr = original_.computations[0].expressions;
+        size_t equal_pos = expr.find('=');
+        if (equal_pos != string::npos) {
+            lhs_ = trim(expr.substr(0, equal_pos));
+            stringstream ss(expr.substr(equal_pos + 1));
+            string segment;
+            while (getline(ss, segment, '*'))
+                terms_.push_back(trim(segment));
+        }
+    }
+    bool reorderable = inputs > 1 && terms_.size() == inputs;
+    for (size_t i = 0; reorderable && i < inputs; i++)
+        reorderable = extract_name(terms_[i]) == string(1, original_.tensors[i + 1].name);
+    if (!reorderable)
+        terms_.clear();
+
+    // (inputs)! overflows 64 bits past 20 inputs
+    enumerable_ = modes_ < 63 && (terms_.empty() || inputs <= 20);
+    if (enumerable_) {
+        orders_ = terms_.empty() ? 1 : factorial(inputs);
+        enumerable_ = !__builtin_mul_overflow(uint64_t(1) << modes_, orders_, &size_) && size_ < UINT64_MAX;
+    }
+
+    if (!enumerable_) {
+        size_ = remaining_ = UINT64_MAX;
+        seen_.insert(kernel_hash(original_));
+        return;
+    }
+
+    // The original counts as drawn: joint draws skip it and draw(op) starts from it
+    uint64_t first = rank(original_);
+    all_ = Shuffle(size_);
+    drawn_.push_back(first);
+    seen_.insert(first);
+    remaining_ = size_ - 1;
+}
+
+uint64_t MutationSpace::radix(MutationOperator op) const
+{
+    switch (op) {
+        case SPARSITY:
+            return modes_ < 64 ? uint64_t(1) << modes_ : UINT64_MAX;
+        case COMMUTATIVITY:
+            return terms_.empty() ? 1 : (enumerable_ ? orders_ : UINT64_MAX);
+        case SCHEDULE:
+            return schedulable_ ? UINT64_MAX : 1;
+        default:
+            return 1;
+    }
+}
+
+uint64_t MutationSpace::Shuffle::at(uint64_t pos) const
+{
+    auto it = swaps.find(pos);
+    return it == swaps.end() ? pos : it->second;
+}
+
+uint64_t MutationSpace::Shuffle::next(tsRng& gen)
+{
+    uint64_t pos = uniform_int_distribution<uint64_t>(0, remaining - 1)(gen);
+    uint64_t last = remaining - 1;
+    uint64_t value = at(pos);
+    if (pos != last) swaps[pos] = at(last);
+    swaps.erase(last);
+    remaining--;
+    return value;
+}
+
+tsKernel MutationSpace::random_kernel(tsRng& gen, bool formats, bool order) const
+{
+    bernoulli_distribution dense(0.5);
+    vector<vector<TensorFormat>> f;
+    for (const auto& t : original_.tensors) {
+        f.push_back(t.storageFormat);
+        for (size_t d = 0; formats && d < t.storageFormat.size(); d++)
+            if (!t.is_pinned(d))
+                f.back()[d] = dense(gen) ? TensorFormat::tsDense : TensorFormat::tsSparse;
+    }
+    vector<size_t> o(terms_.size());
+    for (size_t i = 0; i < o.size(); i++) o[i] = i;
+    if (order) shuffle(o.begin(), o.end(), gen);
+    return build(f, o);
+}
+
+bool MutationSpace::draw(tsRng& gen, tsKernel& mutant)
+{
+    if (enumerable_) {
+        if (remaining_ == 0) return false;
+
+        // draw(op) may have taken some ranks already; the shuffle still holds every unseen one
+        uint64_t value;
+        do {
+            value = all_.next(gen);
+        } while (!seen_.insert(value).second);
+        drawn_.push_back(value);
+        remaining_--;
+
+        mutant = unrank(value);
+        return true;
+    }
+
+    // Too large to enumerate: sample each digit directly, a repeat is practically impossible
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        mutant = random_kernel(gen, true, true);
+        if (seen_.insert(kernel_hash(mutant)).second)
+            return true;
+    }
+    return false;
+}
+
+bool MutationSpace::draw(tsRng& gen, MutationOperator op, tsKernel& mutant)
+{
+    if (radix(op) <= 1) return false;
+
+    if (op == SCHEDULE) {
+        // A random schedule on a random earlier kernel; repeats are rare but possible on small kernels
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            mutant = drawn_.empty() ? original_ : unrank(drawn_[uniform_int_distribution<size_t>(0, drawn_.size() - 1)(gen)]);
+            mutant.computations[0].schedule = random_schedule(mutant, gen);
+            if (!mutant.computations[0].schedule.empty() && scheduled_.insert(kernel_hash(mutant)).second)
+                return true;
+        }
+        return false;
+    }
+
+    if (!enumerable_) {
+        // Vary the operator's digit of the original only
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            mutant = random_kernel(gen, op == SPARSITY, op == COMMUTATIVITY);
+            if (seen_.insert(kernel_hash(mutant)).second)
+                return true;
+        }
+        return false;
+    }
+    if (remaining_ == 0) return false;
+
+    // Parents in random order; those sharing the other digit share one shuffle of op's digit
+    uint64_t format_mask = (uint64_t(1) << modes_) - 1;
+    size_t parents = drawn_.size();
+    size_t start = uniform_int_distribution<size_t>(0, parents - 1)(gen);
+    for (size_t p = 0; p < parents; p++) {
+        uint64_t parent = drawn_[(start + p) % parents];
+        uint64_t other = op == SPARSITY ? parent >> modes_ : parent & format_mask;
+        auto it = digit_.find({op, other});
+        if (it == digit_.end())
+            it = digit_.emplace(make_pair(int(op), other), Shuffle(radix(op))).first;
+
+        Shuffle& values = it->second;
+        while (values.remaining > 0) {
+            uint64_t value = values.next(gen);
+            uint64_t candidate = op == SPARSITY ? digits_to_rank(value, other) : digits_to_rank(other, value);
+            if (!seen_.insert(candidate).second) continue;
+
+            drawn_.push_back(candidate);
+            remaining_--;
+            mutant = unrank(candidate);
+            return true;
+        }
+    }
+    return false;
+}
+
+tsKernel MutationSpace::unrank(uint64_t rank) const
+{
+    if (!enumerable_ || rank >= size_)
+        throw out_of_range("Rank " + to_string(rank) + " is outside the mutation space");
+
+    uint64_t format_digit = rank & ((uint64_t(1) << modes_) - 1);
+    uint64_t order_digit = rank >> modes_;
+
+    vector<vector<TensorFormat>> formats;
+    size_t bit = 0;
+    for (const auto& t : original_.tensors) {
+        formats.push_back(t.storageFormat);
+        for (size_t d = 0; d < t.storageFormat.size(); d++)
+            if (!t.is_pinned(d))
+                formats.back()[d] = ((format_digit >> bit++) & 1) ? TensorFormat::tsDense : TensorFormat::tsSparse;
+    }
+
+    // Lehmer code: digit i (weight (n-1-i)!) picks among the inputs not placed yet
+    vector<size_t> available, order;
+    for (size_t i = 0; i < terms_.size(); i++) available.push_back(i);
+    for (size_t i = 0; i < terms_.size(); i++) {
+        uint64_t weight = factorial(terms_.size() - 1 - i);
+        size_t pick = order_digit / weight;
+        order_digit %= weight;
+        order.push_back(available[pick]);
+        available.erase(available.begin() + pick);
+    }
+    return build(formats, order);
+}
+
+uint64_t MutationSpace::rank(const tsKernel& kernel) const
+{
+    if (!enumerable_)
+        throw out_of_range("The mutation space is too large to rank");
+
+    auto find_tensor = [&](char name) {
+        for (const auto& t : kernel.tensors)
+            if (t.name == name) return &t;
+        throw invalid_argument(string("Tensor ") + name + " is not in the kernel");
+    };
+
+    uint64_t format_digit = 0;
+    size_t bit = 0;
+    for (const auto& t : original_.tensors) {
+        const tsTensor* other = find_tensor(t.name);
+        for (size_t d = 0; d < t.storageFormat.size(); d++) {
+            if (t.is_pinned(d)) continue;
+            if (d < other->storageFormat.size() && other->storageFormat[d] == TensorFormat::tsDense)
+                format_digit |= uint64_t(1) << bit;
+            bit++;
+        }
+    }
+
+    // Position of each of kernel's inputs in the original order
+    vector<size_t> order;
+    for (size_t i = 1; i < kernel.tensors.size() && !terms_.empty(); i++)
+        for (size_t j = 1; j < original_.tensors.size(); j++)
+            if (original_.tensors[j].name == kernel.tensors[i].name) order.push_back(j - 1);
+
+    uint64_t order_digit = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        size_t smaller = 0;
+        for (size_t j = i + 1; j < order.size(); j++)
+            smaller += order[j] < order[i];
+        order_digit += smaller * factorial(order.size() - 1 - i);
+    }
+    return digits_to_rank(format_digit, order_digit);
+}
+
+tsKernel MutationSpace::build(const vector<vector<TensorFormat>>& formats, const vector<size_t>& order) const
+{
+    tsKernel mutant = original_;
+    for (size_t t = 0; t < mutant.tensors.size(); t++)
+        mutant.tensors[t].storageFormat = formats[t];
+
+    bool reordered = false;
+    for (size_t i = 0; i < order.size(); i++)
+        reordered |= order[i] != i;
+    if (!reordered) return mutant;
+
+    // Inputs and the terms of the product in the new order
+    stringstream rhs;
+    for (size_t i = 0; i < order.size(); i++) {
+        mutant.tensors[i + 1] = original_.tensors[order[i] + 1];
+        mutant.tensors[i + 1].storageFormat = formats[order[i] + 1];
+        rhs << (i ? " * " : "") << terms_[order[i]];
+    }
+    mutant.computations[0].expressions = lhs_ + " = " + rhs.str();
+    return mutant;
+}
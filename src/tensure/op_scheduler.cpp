@@ -0,0 +1,156 @@
+#include "tensure/op_scheduler.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+#include <filesystem>
+
+string to_string(SchedulerPolicy policy) {
+    switch (policy) {
+        case SchedulerPolicy::UNIFORM: return "uniform";
+        case SchedulerPolicy::UCB:     return "ucb";
+    }
+    return "unknown";
+}
+
+SchedulerPolicy parseSchedulerPolicy(const string& s) {
+    if (s == "uniform") return SchedulerPolicy::UNIFORM;
+    if (s == "ucb")     return SchedulerPolicy::UCB;
+    throw runtime_error("Unknown operator scheduler: " + s);
+}
+
+OperatorScheduler::OperatorScheduler(SchedulerPolicy policy) : policy_(policy), stats_(COUNT), enabled_(COUNT, true) {}
+
+void OperatorScheduler::disable(MutationOperator op)
+{
+    if (op >= 0 && op < COUNT) enabled_[op] = false;
+}
+
+MutationOperator OperatorScheduler::pick(tsRng& gen, const vector<bool>& available)
+{
+    vector<int> arms;
+    for (int op = 0; op < COUNT; op++)
+        if (enabled_[op] && op < (int)available.size() && available[op]) arms.push_back(op);
+    if (arms.empty()) return COUNT;
+
+    auto pick_one = [&](const vector<int>& among) {
+        return static_cast<MutationOperator>(among[uniform_int_distribution<size_t>(0, among.size() - 1)(gen)]);
+    };
+    if (policy_ == SchedulerPolicy::UNIFORM || arms.size() == 1)
+        return pick_one(arms);
+
+    lock_guard<mutex> lock(mtx_);
+
+    // Every operator is tried once before the scores mean anything
+    vector<int> untried;
+    uint64_t total = 0;
+    double best_rate = 0.0;
+    for (int op : arms) {
+        if (stats_[op].pulls == 0) untried.push_back(op);
+        total += stats_[op].pulls;
+        best_rate = max(best_rate, stats_[op].reward_rate());
+    }
+    if (!untried.empty())
+        return pick_one(untried);
+
+    // UCB1 with the reward rates scaled to [0, 1] by the best one; ties broken at random
+    vector<int> best;
+    double best_score = -1.0;
+    for (int op : arms) {
+        const OperatorStats& s = stats_[op];
+        double mean = best_rate > 0 ? s.reward_rate() / best_rate : 0.0;
+        double score = mean + sqrt(2.0 * log((double)total) / s.pulls);
+        if (score > best_score + 1e-12) {
+            best_score = score;
+            best.assign(1, op);
+        } else if (score > best_score - 1e-12) {
+            best.push_back(op);
+        }
+    }
+    return pick_one(best);
+}
+
+void OperatorScheduler::update(MutationOperator op, const MutantOutcome& outcome)
+{
+    if (op < 0 || op >= COUNT) return;
+    lock_guard<mutex> lock(mtx_);
+    OperatorStats& s = stats_[op];
+    s.pulls++;
+    s.wall_seconds += outcome.wall_seconds;
+    s.bugs += outcome.bug;
+    s.new_code += outcome.new_code;
+    s.outliers += outcome.outlier;
+    s.reward += BUG_REWARD * outcome.bug + NEW_CODE_REWARD * outcome.new_code + OUTLIER_REWARD * outcome.outlier;
+}
+
+json OperatorScheduler::to_json()
+{
+    lock_guard<mutex> lock(mtx_);
+    json ops = json::object();
+    for (int op = 0; op < COUNT; op++) {
+        const OperatorStats& s = stats_[op];
+        ops[to_string(static_cast<MutationOperator>(op))] = {
+            {"pulls", s.pulls}, {"reward", s.reward}, {"wall_seconds", s.wall_seconds},
+            {"bugs", s.bugs}, {"new_code", s.new_code}, {"outliers", s.outliers}
+        };
+    }
+    return {{"policy", to_string(policy_)}, {"operators", ops}};
+}
+
+string OperatorScheduler::report()
+{
+    lock_guard<mutex> lock(mtx_);
+    ostringstream out;
+    out << fixed << setprecision(3);
+    for (int op = 0; op < COUNT; op++) {
+        const OperatorStats& s = stats_[op];
+        out << (op ? "\n" : "") << to_string(static_cast<MutationOperator>(op)) << ": " << s.pulls << " mutants, "
+            << s.bugs << " bugs, " << s.new_code << " new code, " << s.outliers << " outliers, "
+            << s.wall_seconds << " s, " << s.reward_rate() << " reward/s";
+    }
+    return out.str();
+}
+
+void OperatorScheduler::save(const string& file)
+{
+    // Written aside and renamed, so an interrupted campaign never leaves a truncated file
+    string tmp = file + ".tmp";
+    {
+        ofstream out(tmp);
+        if (!out) return;
+        out << to_json().dump(4) << "\n";
+    }
+    error_code ec;
+    filesystem::rename(tmp, file, ec);
+}
+
+void OperatorScheduler::load(const string& file)
+{
+    ifstream in(file);
+    if (!in)
+        throw runtime_error("Cannot open operator statistics " + file);
+    json j;
+    try {
+        in >> j;
+    } catch (const json::exception& e) {
+        throw runtime_error("Cannot parse operator statistics " + file + ": " + e.what());
+    }
+
+    lock_guard<mutex> lock(mtx_);
+    const json& ops = j.value("operators", json::object());
+    for (int op = 0; op < COUNT; op++) {
+        string name = to_string(static_cast<MutationOperator>(op));
+        if (!ops.contains(name)) continue;
+        const json& o = ops[name];
+        OperatorStats& s = stats_[op];
+        s.pulls += o.value("pulls", uint64_t(0));
+        s.reward += o.value("reward", 0.0);
+        s.wall_seconds += o.value("wall_seconds", 0.0);
+        s.bugs += o.value("bugs", uint64_t(0));
+        s.new_code += o.value("new_code", uint64_t(0));
+        s.outliers += o.value("outliers", uint64_t(0));
+    }
+}
@@ -0,0 +1,313 @@
+#include "tensure/patterns.hpp"
+#include "tensure/random_gen.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <numeric>
+
+static double random_value(tsRng& gen, const PatternParams& params)
+{
+    uniform_real_distribution<> value_dist(params.value_min, params.value_max);
+    return round(value_dist(gen) * 100.0) / 100.0;
+}
+
+static uint64_t volume_of(const vector<int>& shape)
+{
+    uint64_t volume = 1;
+    for (int dim : shape)
+        volume *= static_cast<uint64_t>(dim);
+    return volume;
+}
+
+// Append Bernoulli(density) nonzeros of the linearized range [begin, end) by geometric skipping
+static void sample_range(const vector<int>& shape, uint64_t begin, uint64_t end, double density, tsRng& gen, const PatternParams& params, tsTensorData& tensorData)
+{
+    if (density <= 0.0 || begin >= end)
+        return;
+    // geometric_distribution needs 0 < p < 1; a density of 1 keeps every position
+    bool dense = density >= 1.0;
+    geometric_distribution<uint64_t> skip_dist(dense ? 0.5 : density);
+    auto skip = [&]() -> uint64_t { return dense ? 0 : skip_dist(gen); };
+    vector<int> coord(shape.size());
+    for (uint64_t pos = begin + skip(); pos < end; pos += 1 + skip())
+    {
+        uint64_t rest = pos;
+        for (size_t d = shape.size(); d-- > 0;)
+        {
+            coord[d] = static_cast<int>(rest % shape[d]);
+            rest /= shape[d];
+        }
+        tensorData.append(coord.data(), random_value(gen, params));
+    }
+}
+
+// Reorder the nonzeros into row-major order (for the structured patterns, which emit them out of order)
+static void sort_row_major(const vector<int>& shape, tsTensorData& tensorData)
+{
+    size_t rank = shape.size();
+    vector<pair<uint64_t, size_t>> order(tensorData.size());
+    for (size_t n = 0; n < order.size(); n++)
+    {
+        uint64_t pos = 0;
+        for (size_t d = 0; d < rank; d++)
+            pos = pos * shape[d] + tensorData.coord(n)[d];
+        order[n] = {pos, n};
+    }
+    sort(order.begin(), order.end());
+
+    vector<int> coordinate;
+    vector<double> data;
+    coordinate.reserve(tensorData.coordinate.size());
+    data.reserve(tensorData.data.size());
+    for (const auto& [pos, n] : order)
+    {
+        coordinate.insert(coordinate.end(), tensorData.coord(n), tensorData.coord(n) + rank);
+        data.push_back(tensorData.data[n]);
+    }
+    tensorData.clear();
+    tensorData.coordinate = std::move(coordinate);
+    tensorData.data = std::move(data);
+}
+
+// Advance coord through [0, limit)^rank in row-major order; false once it wraps around
+static bool next_offset(vector<int>& coord, int limit)
+{
+    for (size_t d = coord.size(); d-- > 0;)
+    {
+        if (++coord[d] < limit) return true;
+        coord[d] = 0;
+    }
+    return false;
+}
+
+// Dedicated sampler, multi-threaded for large tensors
+static void fill_uniform(const tsTensor& tensor, tsTensorData& tensorData, tsRng& gen, const PatternParams& params)
+{
+    fill_random_tensor_data(tensor, tensorData, params.density, gen(), params.value_min, params.value_max);
+}
+
+static void fill_hyper_sparse(const tsTensor& tensor, tsTensorData& tensorData, tsRng& gen, const PatternParams& params)
+{
+    sample_range(tensor.shape, 0, volume_of(tensor.shape), params.density / 40.0, gen, params, tensorData);
+}
+
+static void fill_empty(const tsTensor&, tsTensorData&, tsRng&, const PatternParams&)
+{
+}
+
+static void fill_diagonal(const tsTensor& tensor, tsTensorData& tensorData, tsRng& gen, const PatternParams& params)
+{
+    size_t rank = tensor.shape.size();
+    if (rank == 0)
+    {
+        tensorData.append(nullptr, random_value(gen, params));
+        return;
+    }
+    int len = *min_element(tensor.shape.begin(), tensor.shape.end());
+    vector<int> coord(rank);
+    for (int i = 0; i < len; i++)
+    {
+        fill(coord.begin(), coord.end(), i);
+        tensorData.append(coord.data(), random_value(gen, params));
+    }
+}
+
+// Each band position is its smallest coordinate lo plus offsets in [0, bandwidth] (one of them 0),
+// so only the band is visited; positions are kept with probability density / 0.4
+static void fill_banded(const tsTensor& tensor, tsTensorData& tensorData, tsRng& gen, const PatternParams& params)
+{
+    int bandwidth = uniform_int_distribution<int>(0, 2)(gen);
+    size_t rank = tensor.shape.size();
+    if (rank == 0)
+    {
+        tensorData.append(nullptr, random_value(gen, params));
+        return;
+    }
+
+    bernoulli_distribution keep_dist(min(max(params.density, 0.0) / PatternParams().density, 1.0));
+    int len = *min_element(tensor.shape.begin(), tensor.shape.end());
+    vector<int> offset(rank), coord(rank);
+    for (int lo = 0; lo < len; lo++)
+    {
+        fill(offset.begin(), offset.end(), 0);
+        do
+        {
+            bool in_band = *min_element(offset.begin(), offset.end()) == 0;
+            for (size_t d = 0; d < rank && in_band; d++)
+            {
+                coord[d] = lo + offset[d];
+                in_band = coord[d] < tensor.shape[d];
+            }
+            if (in_band && keep_dist(gen))
+                tensorData.append(coord.data(), random_value(gen, params));
+        } while (next_offset(offset, bandwidth + 1));
+    }
+    sort_row_major(tensor.shape, tensorData);
+}
+
+// Present blocks are drawn by geometric skipping over the block indices, so only they are visited
+static void fill_block(const tsTensor& tensor, tsTensorData& tensorData, tsRng& gen, const PatternParams& params)
+{
+    const int block = 2;
+    size_t rank = tensor.shape.size();
+    double present = 0.3 * min(max(params.density, 0.0) / PatternParams().density, 1.0);
+    if (present <= 0.0)
+        return;
+
+    vector<int> blocks_per_dim(rank);
+    uint64_t num_blocks = 1;
+    for (size_t d = 0; d < rank; d++)
+    {
+        blocks_per_dim[d] = (tensor.shape[d] + block - 1) / block;
+        num_blocks *= blocks_per_dim[d];
+    }
+
+    geometric_distribution<uint64_t> skip_dist(present);
+    vector<int> corner(rank), offset(rank), coord(rank);
+    for (uint64_t b = skip_dist(gen); b < num_blocks; b += 1 + skip_dist(gen))
+    {
+        uint64_t rest = b;
+        for (size_t d = rank; d-- > 0;)
+        {
+            corner[d] = static_cast<int>(rest % blocks_per_dim[d]) * block;
+            rest /= blocks_per_dim[d];
+        }
+        fill(offset.begin(), offset.end(), 0);
+        do
+        {
+            bool inside = true;
+            for (size_t d = 0; d < rank && inside; d++)
+            {
+                coord[d] = corner[d] + offset[d];
+                inside = coord[d] < tensor.shape[d];
+            }
+            if (inside)
+                tensorData.append(coord.data(), random_value(gen, params));
+        } while (next_offset(offset, block));
+    }
+    sort_row_major(tensor.shape, tensorData);
+}
+
+// Slices along mode 0 are contiguous in the row-major linearization, so each gets its own density
+static void fill_slices(const tsTensor& tensor, tsTensorData& tensorData, tsRng& gen, const PatternParams& params, const vector<double>& slice_density)
+{
+    uint64_t slice_volume = volume_of(tensor.shape) / tensor.shape[0];
+    for (size_t s = 0; s < slice_density.size(); s++)
+        sample_range(tensor.shape, s * slice_volume, (s + 1) * slice_volume, slice_density[s], gen, params, tensorData);
+}
+
+static void fill_power_law(const tsTensor& tensor, tsTensorData& tensorData, tsRng& gen, const PatternParams& params)
+{
+    if (tensor.shape.empty())
+        return fill_uniform(tensor, tensorData, gen, params);
+
+    // Slice of popularity rank r gets density 1 / (r + 1)^1.5, popularity shuffled across slices
+    vector<int> order(tensor.shape[0]);
+    iota(order.begin(), order.end(), 0);
+    shuffle(order.begin(), order.end(), gen);
+
+    vector<double> slice_density(tensor.shape[0]);
+    for (size_t s = 0; s < slice_density.size(); s++)
+        slice_density[s] = 1.0 / pow(order[s] + 1.0, 1.5);
+    fill_slices(tensor, tensorData, gen, params, slice_density);
+}
+
+static void fill_empty_slice(const tsTensor& tensor, tsTensorData& tensorData, tsRng& gen, const PatternParams& params)
+{
+    if (tensor.shape.empty())
+        return fill_uniform(tensor, tensorData, gen, params);
+
+    bernoulli_distribution empty_dist(0.5);
+    vector<double> slice_density(tensor.shape[0]);
+    for (auto& density : slice_density)
+        density = empty_dist(gen) ? 0.0 : params.density;
+    slice_density[uniform_int_distribution<size_t>(0, slice_density.size() - 1)(gen)] = 1.0;
+    fill_slices(tensor, tensorData, gen, params, slice_density);
+}
+
+static mutex& registry_mutex()
+{
+    static mutex mtx;
+    return mtx;
+}
+
+static map<string, PatternFillFn>& registry()
+{
+    static map<string, PatternFillFn> patterns = {
+        {"uniform", fill_uniform},
+        {"hyper-sparse", fill_hyper_sparse},
+        {"empty", fill_empty},
+        {"diagonal", fill_diagonal},
+        {"banded", fill_banded},
+        {"block", fill_block},
+        {"power-law", fill_power_law},
+        {"empty-slice", fill_empty_slice},
+    };
+    return patterns;
+}
+
+void register_sparsity_pattern(const string& name, PatternFillFn fn)
+{
+    if (name.empty() || name == RANDOM_SPARSITY_PATTERN)
+        throw runtime_error("Invalid sparsity pattern name: '" + name + "'");
+    lock_guard<mutex> lock(registry_mutex());
+    registry()[name] = std::move(fn);
+}
+
+vector<string> sparsity_pattern_names()
+{
+    lock_guard<mutex> lock(registry_mutex());
+    vector<string> names;
+    for (const auto& [name, fn] : registry())
+        names.push_back(name);
+    return names;
+}
+
+bool is_sparsity_pattern(const string& name)
+{
+    lock_guard<mutex> lock(registry_mutex());
+    return registry().count(name) != 0;
+}
+
+string random_sparsity_pattern(tsRng& gen)
+{
+    vector<string> names = sparsity_pattern_names();
+    return names[uniform_int_distribution<size_t>(0, names.size() - 1)(gen)];
+}
+
+void fill_pattern_tensor_data(const tsTensor& tensor, tsTensorData& tensorData, const string& pattern, uint64_t seed, const PatternParams& params)
+{
+    PatternFillFn fn;
+    {
+        lock_guard<mutex> lock(registry_mutex());
+        auto it = registry().find(pattern);
+        if (it == registry().end())
+            throw runtime_error("Unknown sparsity pattern: " + pattern);
+        fn = it->second;
+    }
+
+    tensorData.clear();
+    tensorData.rank = tensor.shape.size();
+    tsRng gen(seed);
+    fn(tensor, tensorData, gen, params);
+}
+
+PatternParams DataProfile::sample(tsRng& gen) const
+{
+    PatternParams params;
+    params.value_min = value_min;
+    params.value_max = value_max;
+    // Log-uniform, so that a range like 1e-4 .. 0.5 spreads evenly over the orders of magnitude.
+    // Rounded to DENSITY_STEPS_PER_DECADE steps, so that the data pool sees repeated densities.
+    if (density_min > 0.0 && density_max > density_min)
+    {
+        double exponent = uniform_real_distribution<>(log10(density_min), log10(density_max))(gen);
+        double density = pow(10.0, round(exponent * DENSITY_STEPS_PER_DECADE) / DENSITY_STEPS_PER_DECADE);
+        params.density = min(max(density, density_min), density_max);
+    }
+    else
+        params.density = density_max;
+    return params;
+}
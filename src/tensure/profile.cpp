@@ -0,0 +1,143 @@
+#include "tensure/profile.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+
+json CampaignProfile::to_json() const
+{
+    json j;
+    j["name"] = name;
+    j["min_inputs"] = min_inputs;
+    j["max_inputs"] = max_inputs;
+    j["max_rank"] = max_rank;
+    j["index_pool"] = index_pool;
+    j["dimensions"] = {
+        {"min", dims.min},
+        {"max", dims.max},
+        {"log_uniform", dims.log_uniform},
+        {"boundaries", dims.boundaries},
+        {"boundary_prob", dims.boundary_prob},
+        {"boundary_jitter", dims.boundary_jitter},
+        {"max_tensor_volume", dims.max_tensor_volume},
+        {"max_dense_volume", dims.max_dense_volume},
+    };
+    j["density"] = {{"min", data.density_min}, {"max", data.density_max}};
+    j["values"] = {{"min", data.value_min}, {"max", data.value_max}};
+    return j;
+}
+
+static void check(bool ok, const string& name, const string& what)
+{
+    if (!ok)
+        throw runtime_error("Invalid campaign profile '" + name + "': " + what);
+}
+
+CampaignProfile CampaignProfile::from_json(const string& name, const json& j)
+{
+    CampaignProfile p;
+    p.name = name;
+    p.min_inputs = j.value("min_inputs", p.min_inputs);
+    p.max_inputs = j.value("max_inputs", p.max_inputs);
+    p.max_rank = j.value("max_rank", p.max_rank);
+    p.index_pool = j.value("index_pool", p.index_pool);
+
+    if (j.contains("dimensions"))
+    {
+        const json& d = j["dimensions"];
+        p.dims.min = d.value("min", p.dims.min);
+        p.dims.max = d.value("max", p.dims.max);
+        p.dims.log_uniform = d.value("log_uniform", p.dims.log_uniform);
+        p.dims.boundaries = d.value("boundaries", p.dims.boundaries);
+        p.dims.boundary_prob = d.value("boundary_prob", p.dims.boundary_prob);
+        p.dims.boundary_jitter = d.value("boundary_jitter", p.dims.boundary_jitter);
+        p.dims.max_tensor_volume = d.value("max_tensor_volume", p.dims.max_tensor_volume);
+        p.dims.max_dense_volume = d.value("max_dense_volume", p.dims.max_dense_volume);
+
+        // Shorthand for every power of two within [min, max]
+        if (d.value("power_of_two_boundaries", false))
+        {
+            for (long long b = 1; b <= p.dims.max; b *= 2)
+            {
+                if (b >= p.dims.min) p.dims.boundaries.push_back(static_cast<int>(b));
+            }
+        }
+    }
+    if (j.contains("density"))
+    {
+        p.data.density_min = j["density"].value("min", p.data.density_min);
+        p.data.density_max = j["density"].value("max", p.data.density_max);
+    }
+    if (j.contains("values"))
+    {
+        p.data.value_min = j["values"].value("min", p.data.value_min);
+        p.data.value_max = j["values"].value("max", p.data.value_max);
+    }
+
+    // Each generated index appears in two inputs, so there must be at least two
+    check(p.min_inputs >= 2 && p.max_inputs >= p.min_inputs, name, "need 2 <= min_inputs <= max_inputs");
+    check(p.max_inputs <= 25, name, "at most 25 inputs (tensors are named B..Z)");
+    check(!p.index_pool.empty() && set<char>(p.index_pool.begin(), p.index_pool.end()).size() == p.index_pool.size(), name, "index_pool must hold distinct characters");
+    check(p.max_rank >= 1 && p.max_rank <= static_cast<int>(p.index_pool.size()), name, "need 1 <= max_rank <= size of index_pool");
+    check(p.dims.min >= 1 && p.dims.max >= p.dims.min, name, "need 1 <= dimensions.min <= dimensions.max");
+    check(p.dims.boundary_prob >= 0.0 && p.dims.boundary_prob <= 1.0 && p.dims.boundary_jitter >= 0, name, "invalid dimension boundaries");
+    check(p.data.density_min > 0.0 && p.data.density_max >= p.data.density_min && p.data.density_max <= 1.0, name, "need 0 < density.min <= density.max <= 1");
+    check(p.data.value_max > p.data.value_min, name, "need values.min < values.max");
+    return p;
+}
+
+static json read_profiles(const string& profiles_file)
+{
+    ifstream in(profiles_file);
+    if (!in)
+        throw runtime_error("Cannot open profiles file " + profiles_file);
+    json j;
+    try {
+        in >> j;
+    } catch (const json::exception& e) {
+        throw runtime_error("Cannot parse profiles file " + profiles_file + ": " + e.what());
+    }
+    if (!j.contains("profiles") || !j["profiles"].is_object())
+        throw runtime_error("Profiles file " + profiles_file + " has no \"profiles\" object");
+    return j["profiles"];
+}
+
+CampaignProfile load_campaign_profile(const string& profiles_file, const string& name)
+{
+    json profiles = profiles_file.empty() ? json::object() : read_profiles(profiles_file);
+    if (!profiles.contains(name))
+    {
+        if (name == "default")
+            return CampaignProfile();
+        throw runtime_error("No profile '" + name + "' in " + (profiles_file.empty() ? string("(no profiles file)") : profiles_file));
+    }
+    try {
+        return CampaignProfile::from_json(name, profiles[name]);
+    } catch (const json::exception& e) {
+        throw runtime_error("Invalid campaign profile '" + name + "': " + e.what());
+    }
+}
+
+vector<string> campaign_profile_names(const string& profiles_file)
+{
+    vector<string> names;
+    for (auto& [name, profile] : read_profiles(profiles_file).items())
+        names.push_back(name);
+    return names;
+}
+
+int sample_dimension(const DimensionProfile& dims, tsRng& gen)
+{
+    if (!dims.boundaries.empty() && bernoulli_distribution(dims.boundary_prob)(gen))
+    {
+        int b = dims.boundaries[uniform_int_distribution<size_t>(0, dims.boundaries.size() - 1)(gen)];
+        return max(1, b + uniform_int_distribution<int>(-dims.boundary_jitter, dims.boundary_jitter)(gen));
+    }
+    if (dims.log_uniform)
+    {
+        double x = exp(uniform_real_distribution<>(log(dims.min), log(dims.max + 1.0))(gen));
+        return min(dims.max, max(dims.min, static_cast<int>(x)));
+    }
+    return uniform_int_distribution<int>(dims.min, dims.max)(gen);
+}
@@ -1,179 +1,251 @@
 #include "tensure/random_gen.hpp"
+#include "tensure/tensor_io.hpp"
+#include "tensure/mutation_space.hpp"
 
-map<char, int> map_id_to_val(const std::vector<char>& idxs)
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+map<char, int> map_id_to_val(const std::vector<char>& idxs, tsRng& gen, const DimensionProfile& dims)
 {
     std::map<char, int> id_val_map;
 
-    if (idxs.empty()) {
-        // Nothing to assign, return empty map
-        return id_val_map;
+    for (auto& idx : idxs) {
+        id_val_map[idx] = sample_dimension(dims, gen);
     }
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-
-    // Determine upper bound for distribution
-    int upper = std::min(6, static_cast<int>(idxs.size()));
+    return id_val_map;
+}
 
-    // Ensure lower bound <= upper bound
-    int lower = 3;
-    if (upper < lower) {
-        upper = lower; // safe fallback
+// Halve the largest dimension of any tensor above max_volume until all fit. Dimensions belong to
+// indices, so every tensor sharing the index shrinks with it.
+static void fit_tensor_volume(map<char, int>& id_val_map, const vector<tsTensor>& tensors, uint64_t max_volume)
+{
+    if (max_volume == 0) return;
+    for (const auto& tensor : tensors) {
+        while (true) {
+            uint64_t volume = 1;
+            char largest = 0;
+            for (char idx : tensor.idxs) {
+                volume *= id_val_map[idx];
+                if (largest == 0 || id_val_map[idx] > id_val_map[largest]) largest = idx;
+            }
+            if (volume <= max_volume || largest == 0 || id_val_map[largest] == 1) break;
+            id_val_map[largest] /= 2;
+        }
     }
+}
 
-    std::uniform_int_distribution<int> dist(lower, upper);
-
-    for (auto& idx : idxs) {
-        id_val_map[idx] = dist(gen);
+// Pin the largest modes of each tensor Sparse until the rest span at most max_dense_volume positions,
+// so neither the tensor nor any of its mutants allocates a dense level beyond the limit
+static void cap_dense_volume(vector<tsTensor>& tensors, uint64_t max_dense_volume)
+{
+    if (max_dense_volume == 0) return;
+    for (auto& tensor : tensors) {
+        tensor.pinned.resize(tensor.shape.size(), false);
+        while (true) {
+            double volume = 1.0;
+            int largest = -1;
+            for (size_t d = 0; d < tensor.shape.size(); d++) {
+                if (tensor.pinned[d]) continue;
+                volume *= tensor.shape[d];
+                if (largest < 0 || tensor.shape[d] > tensor.shape[largest]) largest = static_cast<int>(d);
+            }
+            if (volume <= static_cast<double>(max_dense_volume) || largest < 0) break;
+            tensor.storageFormat[largest] = TensorFormat::tsSparse;
+            tensor.pinned[largest] = true;
+        }
+        if (find(tensor.pinned.begin(), tensor.pinned.end(), true) == tensor.pinned.end())
+            tensor.pinned.clear();
     }
-
-    return id_val_map;
 }
 
-TensorFormat random_format(mt19937& gen) {
+TensorFormat random_format(tsRng& gen) {
     uniform_int_distribution<int> dist(0, 1);
     return dist(gen) ? tsSparse : tsDense;
 }
 
-static void __fillTensorRecursive(const tsTensor& tensor, tsTensorData& tensorData, vector<int>& current_coordinate, mt19937& gen, bernoulli_distribution& insert_dist, int depth)
-{
-    if (depth == tensor.shape.size())
-    {
-        // insert the data
-        uniform_real_distribution<> dist(0.0, 0.5);
-        double randomValue = dist(gen);
+// Positions per sampling chunk. Chunks are seeded by their index, so the generated tensor
+// depends only on the seed, never on how many threads took part.
+static const uint64_t SAMPLE_CHUNK = 1ull << 20;
 
-        ostringstream oss;
-        oss << std::fixed << std::setprecision(2) << randomValue;
-        std::string strValue = oss.str();
-        // LOG_DEBUG("Inserting data: " + strValue);
+// Below this many chunks the tensor is sampled on the calling thread
+static const uint64_t PARALLEL_MIN_CHUNKS = 4;
 
-        if (insert_dist(gen)) {
-            tensorData.insert(current_coordinate, stod(strValue));
-        }
-        return;
-    }
-    // LOG_DEBUG("Recursive: " + to_string(tensor.shape.size()));
-    // LOG_DEBUG("Recursive depth: " + to_string(depth));
-    for (size_t i = 0; i < tensor.shape[depth]; i++) {
-        current_coordinate[depth] = i;
-        __fillTensorRecursive(tensor, tensorData, current_coordinate, gen, insert_dist, depth+1);
-    }
-}
+// Helper threads available to all samplings together. Samplings run inside the fuzzer's job
+// workers, so a per-call thread count would multiply with the number of concurrent jobs.
+static atomic<int> g_free_sampler_threads{static_cast<int>(max(1u, thread::hardware_concurrency()))};
 
-static bool tns_tensor_data_save(const tsTensor& tensor, const tsTensorData& tsData, const string& filename)
+// Take up to `wanted` helper threads from the shared budget (possibly none)
+static int reserve_sampler_threads(int wanted)
 {
-    if (tsData.tfmt != "tns") {
-        cout << "Unsupported file format save function called: " << tsData.tfmt << "\n";
-    }
-    ofstream out(filename);
+    int free = g_free_sampler_threads.load();
+    int taken;
+    do {
+        taken = min(wanted, max(free, 0));
+    } while (taken > 0 && !g_free_sampler_threads.compare_exchange_weak(free, free - taken));
+    return taken;
+}
 
-    if (!out) {
-        cerr << "Error: could not open file " << filename << endl;
-        LOG_WARN("Error: could not open file " + filename);
-        return false;
-    }
+typedef struct SampledChunk {
+    vector<int> coordinate;     // rank ints per nonzero, as in tsTensorData
+    vector<double> values;
+} SampledChunk;
 
-    // save the actual tensor data
-    for (size_t i = 0; i < tsData.coordinate.size(); i++)
+// Sample the nonzero positions in [begin, end) of the linearized index space. The gap between two
+// nonzeros of a Bernoulli(density) sequence is geometric, so the cost is O(nnz) rather than O(end - begin).
+static void __sampleChunk(const vector<int>& shape, uint64_t begin, uint64_t end, double density, uint64_t seed, uint64_t chunk, double value_min, double value_max, SampledChunk& out)
+{
+    tsRng gen(seed, chunk);
+    // geometric_distribution needs 0 < p < 1; a density of 1 keeps every position
+    bool dense = density >= 1.0;
+    geometric_distribution<uint64_t> skip_dist(dense ? 0.5 : density);
+    auto skip = [&]() -> uint64_t { return dense ? 0 : skip_dist(gen); };
+    uniform_real_distribution<> value_dist(value_min, value_max);
+
+    size_t rank = shape.size();
+    size_t expected = static_cast<size_t>((end - begin) * density * 1.1) + 16;
+    out.coordinate.reserve(expected * rank);
+    out.values.reserve(expected);
+
+    for (uint64_t pos = begin + skip(); pos < end; pos += 1 + skip())
     {
-        for (size_t j = 0; j < tsData.coordinate[i].size(); j++)
+        // delinearize (row-major)
+        size_t base = out.coordinate.size();
+        out.coordinate.resize(base + rank);
+        uint64_t rest = pos;
+        for (size_t d = rank; d-- > 0;)
         {
-            out << tsData.coordinate[i][j] << " ";
+            out.coordinate[base + d] = static_cast<int>(rest % shape[d]);
+            rest /= shape[d];
         }
-        out << tsData.data[i] << "\n";
+        // Values keep two decimals so that they survive any text round trip exactly as written
+        out.values.push_back(round(value_dist(gen) * 100.0) / 100.0);
     }
-    out.close();
-    return true;
 }
 
-static bool ttx_tensor_data_save(const tsTensor& tensor, const tsTensorData& tsData, const string& filename)
+void fill_random_tensor_data(const tsTensor& tensor, tsTensorData& tensorData, double density, uint64_t seed, double value_min, double value_max)
 {
-    if (tsData.tfmt != "ttx") {
-        cout << "Unsupported file format save function called: " << tsData.tfmt << "\n";
-    }
+    tensorData.clear();
 
-    ofstream out(filename);
-    if (!out) {
-        cerr << "Error: could not open file " << filename << endl;
-        LOG_WARN("Error: could not open file " + filename);
-        return false;
-    }
+    size_t rank = tensor.shape.size();
+    uint64_t volume = 1;
+    for (int dim : tensor.shape)
+        volume *= static_cast<uint64_t>(dim);
+    if (volume == 0 || density <= 0.0)
+        return;
+    density = min(density, 1.0);
 
-    // save the header for the ttx
-    string header = "%%MatrixMarket tensor coordinate real general";
-    // if (tsData.coordinate[0].size() == 2)
-    // {
-    //     header = "%%MatrixMarket matrix coordinate real general";
-    // }
-    out << header << "\n";
+    uint64_t num_chunks = (volume + SAMPLE_CHUNK - 1) / SAMPLE_CHUNK;
+    vector<SampledChunk> chunks(num_chunks);
+    auto sample = [&](uint64_t c) {
+        __sampleChunk(tensor.shape, c * SAMPLE_CHUNK, min(volume, (c + 1) * SAMPLE_CHUNK), density, seed, c, value_min, value_max, chunks[c]);
+    };
 
-    // save the shape of the tensor
-    for (int i = 0; i < tensor.shape.size(); i++)
+    if (num_chunks < PARALLEL_MIN_CHUNKS)
     {
-        out << tensor.shape[i] << " ";
-    }
-    out << tsData.coordinate.size() << "\n";
-
-    // save the actual tensor data
-    for (size_t i = 0; i < tsData.coordinate.size(); i++)
+        for (uint64_t c = 0; c < num_chunks; c++)
+            sample(c);
+    } else {
+        // The calling thread samples too, so the tensor is generated even when no helper is free
+        atomic<uint64_t> next_chunk{0};
+        auto work = [&] {
+            for (uint64_t c = next_chunk++; c < num_chunks; c = next_chunk++)
+                sample(c);
+        };
+        int helpers = reserve_sampler_threads(static_cast<int>(min<uint64_t>(max(1u, thread::hardware_concurrency()), num_chunks)) - 1);
+        vector<thread> workers;
+        for (int t = 0; t < helpers; t++)
+            workers.emplace_back(work);
+        work();
+        for (auto& w : workers)
+            w.join();
+        g_free_sampler_threads += helpers;
+    }
+
+    // Chunks cover consecutive ranges, so concatenating them keeps the coordinates sorted
+    size_t nnz = 0;
+    for (const auto& chunk : chunks)
+        nnz += chunk.values.size();
+    tensorData.rank = rank;
+    tensorData.reserve(nnz);
+
+    for (auto& chunk : chunks)
     {
-        for (size_t j = 0; j < tsData.coordinate[i].size(); j++)
-        {
-            out << tsData.coordinate[i][j] << " ";
-        }
-        out << tsData.data[i] << "\n";
+        tensorData.coordinate.insert(tensorData.coordinate.end(), chunk.coordinate.begin(), chunk.coordinate.end());
+        tensorData.data.insert(tensorData.data.end(), chunk.values.begin(), chunk.values.end());
+        chunk = SampledChunk();
     }
-    out.close();
-    return true;
 }
 
 /**
  * This function generate random tensor data for a given tensors and return the string of filenames for each tensors.
- * 
+ * The sparsity pattern used for each input is recorded in its tsTensor::sparsityPattern.
  * */
-vector<string> generate_random_tensor_data(const vector<tsTensor>& tensors, string location, string file_name_suffix, string tfmt)
+vector<string> generate_random_tensor_data(vector<tsTensor>& tensors, string location, string file_name_suffix, string tfmt, tsRng& gen, const string& pattern, const map<char, const DatasetTensor*>& fixed_data, TensorDataPool* pool, const DataProfile& data_profile)
 {
     vector<string> datafile_names = {};
-    random_device rd;
-    mt19937 gen(rd());
-    bernoulli_distribution insert_dist(0.4);
 
     ensure_directory_exists(location);
 
+    // Files are written in the background while the next tensor is generated
+    vector<future<bool>> pending;
+    vector<string> filenames;
     for (size_t i = 1; i < tensors.size(); i++)
     {
         auto &tensor = tensors[i];
         // cout << tensor.name << endl;
-        tsTensorData tsData;
-        tsData.tfmt = tfmt;
-        vector<int> current_coordinate(tensor.shape.size());
-        
+        shared_ptr<const tsTensorData> to_write;
+
         // LOG_DEBUG("Inserting data to tensor: " + std::string(1, tensor.name));
         // LOG_DEBUG("Tensor shape: " + join(tensor.shape));
         // Fill in the tensor data
-        __fillTensorRecursive(tensor, tsData, current_coordinate, gen, insert_dist, 0);
-
-        // build output file path
+        uint64_t seed = gen();
         string filename = location + "/" + string(1,tensor.name) + (file_name_suffix == "" ? "" : "_") + file_name_suffix + "." + tfmt;
+        auto fixed = fixed_data.find(tensor.name);
+        PatternParams params = data_profile.sample(gen);
+        if (fixed == fixed_data.end() && pool) {
+            // Pooled files are shared between iterations through hard links
+            tensor.sparsityPattern = (pattern == RANDOM_SPARSITY_PATTERN) ? random_sparsity_pattern(gen) : pattern;
+            tensor.density = params.density;
+            shared_ptr<const PooledTensorFile> pooled = pool->acquire(tensor.shape, tensor.sparsityPattern, params, tfmt, seed, gen);
+            pending.push_back(async(launch::deferred, [pooled, filename] {
+                return pooled->written.get() && link_or_copy_file(pooled->file, filename);
+            }));
+            filenames.push_back(filename);
+            continue;
+        }
+        if (fixed != fixed_data.end()) {
+            // Owned by the caller, which outlives the writes (all are awaited below)
+            to_write = shared_ptr<const tsTensorData>(&fixed->second->data, [](const tsTensorData*) {});
+            tensor.sparsityPattern = "dataset:" + fixed->second->path;
+        } else {
+            auto tsData = make_shared<tsTensorData>();
+            tsData->tfmt = tfmt;
+            tensor.sparsityPattern = (pattern == RANDOM_SPARSITY_PATTERN) ? random_sparsity_pattern(gen) : pattern;
+            tensor.density = params.density;
+            fill_pattern_tensor_data(tensor, *tsData, tensor.sparsityPattern, seed, params);
+            to_write = tsData;
+        }
 
         // Write to file
-        bool is_successful = false;
-        if (tfmt == "ttx") {
-            is_successful = ttx_tensor_data_save(tensor, tsData, filename);
-        } else if (tfmt == "tns")
-        {
-            is_successful = tns_tensor_data_save(tensor, tsData, filename);
-        }
+        pending.push_back(tensor_writer().submit(tensor.shape, to_write, filename, tfmt));
+        filenames.push_back(filename);
+    }
 
-        if (!is_successful) {
-            LOG_ERROR("Failed saving the tensor data file: " + filename);
-            break;
+    bool is_successful = true;
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        bool written = pending[i].get();
+        if (!is_successful) continue;
+        if (!written) {
+            LOG_ERROR("Failed saving the tensor data file: " + filenames[i]);
+            is_successful = false;
+            continue;
         }
-        
-        cout << "Saved tensor data: " << filename << endl;
+        cout << "Saved tensor data: " << filenames[i] << endl;
         // LOG_INFO("Generated Tensor Data: "+  filename);
-        datafile_names.push_back(filename);
+        datafile_names.push_back(filenames[i]);
     }
 
     return datafile_names;
@@ -231,8 +303,7 @@ tuple<vector<tsTensor>, std::string> generate_random_einsum(std::string filename
     vector<string> inputTokens = split_string(inputsPart, ',');
 
     // Prepare RNG for formats (reusing your existing setup)
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    tsRng& gen = thread_rng();
 
     vector<tsTensor> tsTensors;
 
@@ -282,7 +353,7 @@ tuple<vector<tsTensor>, std::string> generate_random_einsum(std::string filename
     vector<char> all_idxs = find_idxs(tsTensors);
 
     // 2. Map indices to random dimension sizes
-    map<char, int> id_val_map = map_id_to_val(all_idxs);
+    map<char, int> id_val_map = map_id_to_val(all_idxs, gen);
 
     // 3. Backfill the shape into the tensors
     for (auto &tensor : tsTensors)
@@ -297,12 +368,9 @@ tuple<vector<tsTensor>, std::string> generate_random_einsum(std::string filename
 }
 
 // DONE
-tuple<vector<tsTensor>, std::string> generate_random_einsum(int numInputs, int maxRank)
+tuple<vector<tsTensor>, std::string> generate_random_einsum(int numInputs, int maxRank, tsRng& gen, const std::string& pool, const DimensionProfile& dims)
 {
-    // static const std::string pool = "ijklmnopqrstu";
-    static const std::string pool = "ijklmn";
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    maxRank = std::min<int>(maxRank, pool.size());
     std::uniform_int_distribution<> rankDist(1, maxRank);
     std::uniform_int_distribution<> idxDist(0, pool.size()-1);
 
@@ -411,7 +479,8 @@ tuple<vector<tsTensor>, std::string> generate_random_einsum(int numInputs, int m
     // Step 5: Build random shapes for all tensors
     vector<char> all_idxs = find_idxs(tsTensors);
     // std::cout << join(all_idxs) << endl;
-    map<char, int> id_val_map = map_id_to_val(all_idxs);
+    map<char, int> id_val_map = map_id_to_val(all_idxs, gen, dims);
+    fit_tensor_volume(id_val_map, tsTensors, dims.max_tensor_volume);
     for (auto &tensor : tsTensors)
     {
         for (size_t i = 0; i < tensor.idxs.size(); i++)
@@ -419,121 +488,11 @@ tuple<vector<tsTensor>, std::string> generate_random_einsum(int numInputs, int m
             tensor.shape.push_back(id_val_map[tensor.idxs[i]]);
         }
     }
+    cap_dense_volume(tsTensors, dims.max_dense_volume);
 
     return {tsTensors, (lhs + " = " + rhs)};
 }
 
-bool apply_sparsity_mutation(tsKernel& kernel, mt19937& gen) {
-    if (kernel.tensors.empty()) return false;
-
-    // 1. Pick a random tensor to mutate
-    uniform_int_distribution<> tensor_dist(0, kernel.tensors.size() - 1);
-    int t_idx = tensor_dist(gen);
-    tsTensor& tensor = kernel.tensors[t_idx];
-
-    // 2. Generate all possible formats for this tensor's shape
-    vector<vector<string>> all_formats = generate_all_formats(tensor.shape.size());
-    if (all_formats.empty()) return false;
-
-    // 3. Pick a random format
-    uniform_int_distribution<> fmt_dist(0, all_formats.size() - 1);
-    vector<string>& selected_fmt_str = all_formats[fmt_dist(gen)];
-    
-    // 4. Convert string format to your enum/struct format
-    vector<TensorFormat> new_format = parseTensorFormat(selected_fmt_str);
-
-    // 5. Check if it's actually different from current
-    if (is_equal(tensor.storageFormat, new_format)) {
-        return false; 
-    }
-
-    // 6. Apply mutation
-    tensor.storageFormat = new_format;
-    return true;
-}
-
-// --- Helper: Trim whitespace ---
-string trim(const string& str) {
-    size_t first = str.find_first_not_of(" \t");
-    if (string::npos == first) return str;
-    size_t last = str.find_last_not_of(" \t");
-    return str.substr(first, (last - first + 1));
-}
-
-// --- Helper: Extract Tensor Name from "Name(indices)" ---
-string extract_name(const string& term) {
-    size_t paren_pos = term.find('(');
-    if (paren_pos == string::npos) return trim(term);
-    return trim(term.substr(0, paren_pos));
-}
-
-bool apply_commutativity_mutation(tsKernel& kernel, mt19937& gen) {
-    tsComputation& comp = kernel.computations[0];
-    string einsum_str_expr = comp.expressions;
-
-    // Separate LHS and RHS of einsum
-    size_t equal_pos = einsum_str_expr.find("=");
-    if (equal_pos == string::npos) return false; // invalid format
-
-    string lhs_str = einsum_str_expr.substr(0, equal_pos);
-    string rhs_str = einsum_str_expr.substr(equal_pos + 1);
-
-    // Split RHS by '*' delimitter
-    vector<string> terms;
-    stringstream ss(rhs_str);
-    string segment;
-    while (getline(ss, segment, '*')) {
-        terms.push_back(segment);
-    }
-
-    if (terms.size() < 2) {
-        return false; // Not enough terms to apply commutativity
-    }
-
-    // shuffle terms to create a new grouping
-    shuffle(terms.begin(), terms.end(), gen);
-    stringstream new_rhs;
-    for (size_t i = 0; i < terms.size(); i++) {
-        new_rhs << terms[i];
-        if (i < terms.size() - 1) {
-            new_rhs << " * ";
-        }
-    }
-
-    comp.expressions = lhs_str + "= " + new_rhs.str();
-
-    // Synchronize the kernel.tensors vector, just in case
-    map<string, tsTensor> tensor_map;
-    for (const auto& t : kernel.tensors) {
-        tensor_map[string(1, t.name)] = t;
-    }
-
-    vector<tsTensor> new_tensor_list;
-    string out_name = extract_name(lhs_str);
-    if (tensor_map.find(out_name) != tensor_map.end()) {
-        new_tensor_list.push_back(tensor_map[out_name]);
-    } else {
-        // Fallback: If parsing failed, maybe don't mutate vector to prevent crash
-        return true;
-    }
-
-    // Add Input Tensors (RHS) in the SHUFFLED order
-    for (const auto& term : terms) {
-        string in_name = extract_name(term);
-        if (tensor_map.find(in_name) != tensor_map.end()) {
-            new_tensor_list.push_back(tensor_map[in_name]);
-        }
-    }
-
-    // Replace the old vector
-    // Only do this if we successfully found all tensors
-    if (new_tensor_list.size() == kernel.tensors.size()) {
-        kernel.tensors = new_tensor_list;
-    }
-
-    return true;
-}
-
 // vector<string> sparsity_mutation(const fs::path kernel_directory, const fs::path& original_kernel_file, tsKernel &kernel, int max_mutants)
 // {
 //     vector<tsTensor>& tensors = kernel.tensors;
@@ -616,126 +575,166 @@ bool apply_commutativity_mutation(tsKernel& kernel, mt19937& gen) {
 //     return mutated_file_names;
 // }
 
-// Helper to generate a unique string key for a specific kernel state
-// This prevents saving duplicate files and ensures uniqueness
-string get_kernel_signature(const tsKernel& kernel) {
-    string sig = "";
-    for(const auto& t : kernel.tensors) {
-        sig += string(1, t.name) + ":";
-        for(const auto& fmt : t.storageFormat) {
-            // Assuming TensorFormat has a string representation or enum value
-            sig += to_string(static_cast<int>(fmt)) + ","; 
+uint64_t kernel_hash(const tsKernel& kernel) {
+    uint64_t h = 0x9E3779B97F4A7C15ull;
+    auto fold = [&h](uint64_t x) {
+        h ^= x;
+        h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 27; h *= 0x94D049BB133111EBull;
+        h ^= h >> 31;
+    };
+    for (const auto& t : kernel.tensors) {
+        fold(static_cast<unsigned char>(t.name));
+        fold(t.idxs.size());
+        for (char idx : t.idxs) fold(static_cast<unsigned char>(idx));
+        for (TensorFormat fmt : t.storageFormat) fold(static_cast<uint64_t>(fmt));
+    }
+    // Expressions without their spacing, which mutations do not preserve
+    for (const auto& comp : kernel.computations) {
+        fold(';');
+        for (char c : comp.expressions)
+            if (!isspace(static_cast<unsigned char>(c))) fold(static_cast<unsigned char>(c));
+        for (const auto& cmd : comp.schedule) {
+            fold('|');
+            for (char c : to_string(cmd)) fold(static_cast<unsigned char>(c));
         }
-        sig += "|";
     }
-    // Add data type info to signature if you support data mutation
-    return sig;
+    return h;
 }
 
-string mutate_single_unique_kernel(const fs::path& directory, const string& original_kernel_filename, MutationOperator mutation_op, set<string>& generated_signatures, int mutation_id) 
+vector<tsScheduleCommand> random_schedule(const tsKernel& kernel, tsRng& gen)
 {
-    fs::path full_filename = directory / original_kernel_filename;
-    tsKernel original_kernel;
-    original_kernel.loadJson(full_filename.string());
-
-    // Initialize RNG
-    random_device rd;
-    mt19937 gen(rd());
-
-    // Ensure the original kernel is in the history so we don't mutate back to it
-    generated_signatures.insert(get_kernel_signature(original_kernel));
-
-    // Try multiple times to find a unique mutant
-    // (because we might randomly pick a format we've already generated before)
-    int max_retries = 100;
-    for (int attempt = 0; attempt < max_retries; ++attempt) {
-        // Copy original to a temp object for mutation
-        tsKernel mutant_kernel = original_kernel;
-        bool mutation_success = false;
-
-        switch (mutation_op) {
-            case SPARSITY:
-                mutation_success = apply_sparsity_mutation(mutant_kernel, gen);
-                break;
-            case COMMUTATIVITY:
-                mutation_success = apply_commutativity_mutation(mutant_kernel, gen);
-                break;
-            default:
-                break;
-        }
-
-        if (!mutation_success) continue; // Mutation logic failed, retry
-
-        // Check uniqueness
-        string new_sig = get_kernel_signature(mutant_kernel);
-        if (generated_signatures.find(new_sig) == generated_signatures.end()) {
-            // Unique mutant found
-            // save it
-            generated_signatures.insert(new_sig);
-            
-            fs::path new_filename = directory / ("kernel" + to_string(mutation_id) + ".json");
-            fs::path abs_output_path = fs::absolute(new_filename);
-            cout << "Saving mutated kernel to: " << new_filename.string() << "\n";
-            mutant_kernel.saveJson(new_filename.string());
+    if (kernel.computations.size() != 1 || kernel.tensors.empty()) return {};
+
+    // Loops of TACO's concrete statement: the output's indices, then the reduction indices as they appear
+    const vector<char>& out_idxs = kernel.tensors[0].idxs;
+    vector<string> loops;
+    for (const auto& t : kernel.tensors)
+        for (char idx : t.idxs)
+            if (find(loops.begin(), loops.end(), string(1, idx)) == loops.end()) loops.push_back(string(1, idx));
+    if (loops.empty()) return {};
+    bool reduction = loops.size() > set<char>(out_idxs.begin(), out_idxs.end()).size();
+
+    auto coin = [&](double p) { return bernoulli_distribution(p)(gen); };
+    auto pick = [&](size_t n) { return uniform_int_distribution<size_t>(0, n - 1)(gen); };
+    // Index of the kernel each loop variable was derived from
+    map<string, string> source;
+    for (const auto& var : loops) source[var] = var;
+    auto replace_loop = [&](const string& var, const vector<string>& with) {
+        for (const auto& w : with) source[w] = source[var];
+        auto it = find(loops.begin(), loops.end(), var);
+        it = loops.erase(it);
+        loops.insert(it, with.begin(), with.end());
+    };
 
-            return new_filename.string();
+    vector<tsScheduleCommand> schedule;
+
+    // A workspace for the product over the innermost output index, while a reduction runs inside
+    // it. The other output indices are loops around it, so a 1-D workspace holds every free
+    // variable of the product; over an outer index it would not.
+    if (reduction && !out_idxs.empty() && coin(0.25))
+        schedule.push_back({"precompute", {string(1, out_idxs.back())}, "", 0, string(1, out_idxs.back())});
+
+    // Iterate an index over the positions of an input that stores it compressed
+    vector<pair<char, char>> compressed;   // (index, tensor)
+    for (size_t t = 1; t < kernel.tensors.size(); t++)
+        for (size_t d = 0; d < kernel.tensors[t].idxs.size() && d < kernel.tensors[t].storageFormat.size(); d++)
+            if (kernel.tensors[t].storageFormat[d] == TensorFormat::tsSparse)
+                compressed.push_back({kernel.tensors[t].idxs[d], kernel.tensors[t].name});
+    if (!compressed.empty() && coin(0.3)) {
+        auto [idx, tensor] = compressed[pick(compressed.size())];
+        string var(1, idx);
+        schedule.push_back({"pos", {var, var + "pos"}, string(1, tensor), 0, source[var]});
+        replace_loop(var, {var + "pos"});
+    }
+
+    for (size_t n = uniform_int_distribution<size_t>(0, 2)(gen); n > 0; n--) {
+        string var = loops[pick(loops.size())];
+        int factor = 1 << uniform_int_distribution<int>(1, 4)(gen);
+        schedule.push_back({"split", {var, var + "0", var + "1"}, "", factor, source[var]});
+        replace_loop(var, {var + "0", var + "1"});
+    }
+
+    if (loops.size() > 1 && coin(0.5)) {
+        vector<string> order = loops;
+        shuffle(order.begin(), order.end(), gen);
+        if (order != loops) {
+            schedule.push_back({"reorder", order, "", 0, ""});
+            loops = order;
         }
-        // If we are here, we generated a mutant we have already seen - retry
     }
 
-    return ""; // Failed to generate a unique mutant after retries
+    if (coin(0.3)) {
+        string var = loops[pick(loops.size())];
+        schedule.push_back({"unroll", {var}, "", 2 << pick(3), source[var]});
+    }
 
+    // Parallelize last, as TACO expects, and only the outermost loop
+    if (coin(0.3))
+        schedule.push_back({"parallelize", {loops[0]}, "", 0, source[loops[0]]});
+
+    if (schedule.empty()) {
+        string var = loops[pick(loops.size())];
+        schedule.push_back({"split", {var, var + "0", var + "1"}, "", 1 << uniform_int_distribution<int>(1, 4)(gen), source[var]});
+    }
+    return schedule;
 }
 
-MutationOperator pick_random_op(std::mt19937& gen) {
-    // Create a distribution from 0 to (NUM_OPS - 1)
-    std::uniform_int_distribution<> dist(0, COUNT - 1);
-    
-    // Generate the number and cast it back to the Enum type
-    int random_int = dist(gen);
-    return static_cast<MutationOperator>(random_int);
+vector<tsKernel> mutate_equivalent_kernels(const tsKernel& original, tsRng& gen, int max_mutants)
+{
+    // Never more mutants than the space holds: small spaces are enumerated completely
+    MutationSpace space(original);
+    vector<tsKernel> kernels{original};
+    while ((int)kernels.size() <= max_mutants) {
+        tsKernel mutant;
+        if (!space.draw(gen, mutant)) break;
+        kernels.push_back(std::move(mutant));
+    }
+    return kernels;
 }
 
-vector<string> mutate_equivalent_kernel(const fs::path& directory, const string& original_kernel_filename, int max_mutants)
+vector<tsKernel> mutate_equivalent_kernels(const tsKernel& original, tsRng& gen, int max_mutants, OperatorScheduler& scheduler, vector<MutationOperator>& ops)
 {
-    // 1. Initialize the pool of sources with just the original file
-    vector<string> source_pool;
-    source_pool.push_back(original_kernel_filename);
-
-    vector<string> mutated_kernel_files;
-    set<string> generated_signatures;
-
-    fs::path full_filename = directory / original_kernel_filename;
-    mutated_kernel_files.push_back(full_filename.string());
-    tsKernel orig_kernel;
-    orig_kernel.loadJson(full_filename.string());
-    generated_signatures.insert(get_kernel_signature(orig_kernel));
-
-    random_device rd;
-    mt19937 gen(rd());
-
-    int safeguard_limit = max_mutants * 10; // to prevent infinite loops
-    for (int mutation_id = 1; mutation_id <= max_mutants; ++mutation_id) {
-
-        // Pick a random parent kernel from the pool to mutate
-        uniform_int_distribution<> dist(0, source_pool.size() - 1);
-        string parent_file_name = source_pool[dist(gen)];
-        string full_mutated_file_name = mutate_single_unique_kernel(directory, parent_file_name, pick_random_op(gen), generated_signatures, mutation_id);
-        if (!full_mutated_file_name.empty()) {
-            mutated_kernel_files.push_back(full_mutated_file_name);
-
-            // Add the new mutant to the pool
-            source_pool.push_back(fs::path(full_mutated_file_name).filename().string());
-        } else {
-            // No more unique mutants can be generated
-            mutation_id--;
-            if (--safeguard_limit <= 0) {
-                LOG_WARN("Reached safeguard limit while mutating kernels. Stopping further mutations.");
-                break;
-            }
+    MutationSpace space(original);
+    vector<tsKernel> kernels{original};
+    ops.assign(1, COUNT);
+
+    vector<bool> available(COUNT);
+    for (int op = 0; op < COUNT; op++)
+        available[op] = space.radix(static_cast<MutationOperator>(op)) > 1;
+
+    // An operator that has nothing new to offer is left out for the rest of this kernel
+    while ((int)kernels.size() <= max_mutants) {
+        MutationOperator op = scheduler.pick(gen, available);
+        if (op == COUNT) break;
+
+        tsKernel mutant;
+        if (!space.draw(gen, op, mutant)) {
+            available[op] = false;
+            continue;
         }
+        kernels.push_back(std::move(mutant));
+        ops.push_back(op);
     }
+    return kernels;
+}
+
+vector<string> mutant_kernel_files(const fs::path& directory, const string& original_kernel_filename, size_t count)
+{
+    vector<string> files;
+    for (size_t i = 0; i < count; i++)
+        files.push_back((directory / (i == 0 ? original_kernel_filename : "kernel" + to_string(i) + ".json")).string());
+    return files;
+}
 
-    // cout << kernel << endl;
-    return mutated_kernel_files;
-}
\ No newline at end of file
+vector<string> mutate_equivalent_kernel(const fs::path& directory, const string& original_kernel_filename, tsRng& gen, int max_mutants)
+{
+    tsKernel original;
+    original.loadJson((directory / original_kernel_filename).string());
+    vector<tsKernel> kernels = mutate_equivalent_kernels(original, gen, max_mutants);
+
+    vector<string> files = mutant_kernel_files(directory, original_kernel_filename, kernels.size());
+    for (size_t i = 1; i < kernels.size(); i++)
+        kernels[i].saveJson(files[i]);
+    return files;
+}
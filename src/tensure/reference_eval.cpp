@@ -0,0 +1,712 @@
+#include "tensure/reference_eval.hpp"
+#include "tensure/comparator.hpp"
+#include "tensure/tensor_io.hpp"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const size_t MAX_EVAL_INPUTS = 32;
+
+// Loop nest over every index of the einsum; strides are 0 for indices a tensor does not use
+typedef struct LoopPlan {
+    size_t loops = 0;
+    vector<int64_t> extent;                 // per loop
+    size_t inputs = 0;
+    vector<const double*> in;
+    vector<int64_t> in_stride;              // [input * loops + loop]
+    vector<vector<size_t>> complete_at;     // inputs whose last index is this loop
+    double* out = nullptr;
+    vector<int64_t> out_stride;             // per loop
+} LoopPlan;
+
+// Row buffer of the innermost loop, reused across calls
+thread_local vector<double> t_row;
+
+// Innermost loop: multiply the rows of the inputs that move with it, scaled by the others
+void run_inner(const LoopPlan& p, const int64_t* in_off, int64_t out_off)
+{
+    size_t last = p.loops - 1;
+    int64_t n = p.extent[last];
+    double scale = 1.0;
+    for (size_t t = 0; t < p.inputs; t++)
+        if (p.in_stride[t * p.loops + last] == 0)
+            scale *= p.in[t][in_off[t]];
+    if (scale == 0.0)
+        return;
+
+    double* row = t_row.data();
+    fill(row, row + n, scale);
+    for (size_t t = 0; t < p.inputs; t++)
+    {
+        int64_t s = p.in_stride[t * p.loops + last];
+        if (s == 0) continue;
+        const double* src = p.in[t] + in_off[t];
+        if (s == 1)
+            for (int64_t k = 0; k < n; k++) row[k] *= src[k];
+        else
+            for (int64_t k = 0; k < n; k++) row[k] *= src[k * s];
+    }
+
+    double* out = p.out + out_off;
+    int64_t os = p.out_stride[last];
+    if (os == 0)
+    {
+        // Contracted index: reduce the row
+        double acc = 0.0;
+        for (int64_t k = 0; k < n; k++) acc += row[k];
+        out[0] += acc;
+    }
+    else if (os == 1)
+        for (int64_t k = 0; k < n; k++) out[k] += row[k];
+    else
+        for (int64_t k = 0; k < n; k++) out[k * os] += row[k];
+}
+
+// Offsets of iteration i of loop `level`; false if an input completed by this loop is zero there
+inline bool enter(const LoopPlan& p, size_t level, int64_t i, const int64_t* in_off, int64_t* local)
+{
+    for (size_t t = 0; t < p.inputs; t++)
+        local[t] = in_off[t] + i * p.in_stride[t * p.loops + level];
+    for (size_t t : p.complete_at[level])
+        if (p.in[t][local[t]] == 0.0)
+            return false;
+    return true;
+}
+
+template <size_t LEVEL, size_t LOOPS>
+void run_static(const LoopPlan& p, const int64_t* in_off, int64_t out_off)
+{
+    if constexpr (LEVEL + 1 == LOOPS)
+    {
+        run_inner(p, in_off, out_off);
+    }
+    else
+    {
+        int64_t local[MAX_EVAL_INPUTS];
+        for (int64_t i = 0; i < p.extent[LEVEL]; i++)
+            if (enter(p, LEVEL, i, in_off, local))
+                run_static<LEVEL + 1, LOOPS>(p, local, out_off + i * p.out_stride[LEVEL]);
+    }
+}
+
+void run_dynamic(const LoopPlan& p, size_t level, const int64_t* in_off, int64_t out_off)
+{
+    if (level + 1 == p.loops)
+    {
+        run_inner(p, in_off, out_off);
+        return;
+    }
+    int64_t local[MAX_EVAL_INPUTS];
+    for (int64_t i = 0; i < p.extent[level]; i++)
+        if (enter(p, level, i, in_off, local))
+            run_dynamic(p, level + 1, local, out_off + i * p.out_stride[level]);
+}
+
+uint64_t volume_of(const vector<int>& shape)
+{
+    uint64_t volume = 1;
+    for (int dim : shape)
+        volume *= static_cast<uint64_t>(max(dim, 0));
+    return volume;
+}
+
+// Dense row-major copy of an input file
+vector<double> load_dense(const string& file, const vector<int>& shape)
+{
+    vector<double> values(volume_of(shape), 0.0);
+    for_each_output_entry(file, [&](const int64_t* coords, size_t rank, double value) {
+        if (rank != shape.size())
+            throw runtime_error("Rank mismatch in " + file);
+        uint64_t pos = 0;
+        for (size_t d = 0; d < rank; d++)
+        {
+            if (coords[d] < 0 || coords[d] >= shape[d])
+                throw runtime_error("Coordinate out of range in " + file);
+            pos = pos * shape[d] + coords[d];
+        }
+        values[pos] = value;
+        return true;
+    });
+    return values;
+}
+
+// Only the product form the generators emit: "A(...) = B(...) * C(...) * ..."
+bool is_product_einsum(const tsKernel& kernel)
+{
+    if (kernel.computations.size() != 1 || kernel.tensors.size() < 2 || kernel.tensors.size() - 1 > MAX_EVAL_INPUTS)
+        return false;
+    const string& expr = kernel.computations[0].expressions;
+    size_t eq = expr.find('=');
+    return eq != string::npos && expr.find_first_of("+-/", eq) == string::npos;
+}
+
+}
+
+bool evaluate_einsum(const tsKernel& kernel, vector<double>& result, const EinsumEvalLimits& limits)
+{
+    if (!is_product_einsum(kernel))
+        return false;
+
+    // Extent of every index, in order of first appearance
+    vector<char> idxs;
+    map<char, int64_t> extent;
+    for (const tsTensor& t : kernel.tensors)
+    {
+        if (t.idxs.size() != t.shape.size() || volume_of(t.shape) > limits.max_tensor_volume)
+            return false;
+        for (size_t d = 0; d < t.idxs.size(); d++)
+        {
+            auto it = extent.find(t.idxs[d]);
+            if (it == extent.end())
+            {
+                idxs.push_back(t.idxs[d]);
+                extent[t.idxs[d]] = t.shape[d];
+            }
+            else if (it->second != t.shape[d])
+                return false;
+        }
+    }
+    uint64_t work = 1;
+    for (char c : idxs)
+        if (__builtin_mul_overflow(work, static_cast<uint64_t>(extent[c]), &work) || work > limits.max_work)
+            return false;
+
+    // Innermost loop: the index that is the unit-stride (last) mode of the most tensors
+    if (!idxs.empty())
+    {
+        auto unit_count = [&](char c) {
+            int n = 0;
+            for (const tsTensor& t : kernel.tensors)
+                n += !t.idxs.empty() && t.idxs.back() == c;
+            return n;
+        };
+        auto inner = max_element(idxs.begin(), idxs.end(), [&](char a, char b) {
+            return make_pair(unit_count(a), extent[a]) < make_pair(unit_count(b), extent[b]);
+        });
+        rotate(inner, inner + 1, idxs.end());
+    }
+
+    const tsTensor& out = kernel.tensors[0];
+    result.assign(volume_of(out.shape), 0.0);
+    if (work == 0)
+        return true;
+
+    vector<vector<double>> inputs;
+    for (size_t t = 1; t < kernel.tensors.size(); t++)
+    {
+        const tsTensor& tensor = kernel.tensors[t];
+        auto file = kernel.dataFileNames.find(string(1, tensor.name));
+        if (file == kernel.dataFileNames.end())
+            return false;
+        inputs.push_back(load_dense(file->second, tensor.shape));
+    }
+
+    LoopPlan p;
+    p.loops = idxs.size();
+    p.inputs = inputs.size();
+    for (char c : idxs)
+        p.extent.push_back(extent[c]);
+
+    // Row-major strides, summed when an index repeats within a tensor
+    auto strides_of = [&](const tsTensor& t) {
+        vector<int64_t> loop_stride(p.loops, 0);
+        int64_t stride = 1;
+        for (size_t d = t.idxs.size(); d-- > 0;)
+        {
+            size_t loop = find(idxs.begin(), idxs.end(), t.idxs[d]) - idxs.begin();
+            loop_stride[loop] += stride;
+            stride *= t.shape[d];
+        }
+        return loop_stride;
+    };
+    p.complete_at.resize(p.loops);
+    for (size_t t = 0; t < p.inputs; t++)
+    {
+        vector<int64_t> s = strides_of(kernel.tensors[t + 1]);
+        p.in_stride.insert(p.in_stride.end(), s.begin(), s.end());
+        p.in.push_back(inputs[t].data());
+
+        size_t last = 0;
+        bool indexed = false;
+        for (size_t l = 0; l < p.loops; l++)
+            if (s[l] != 0) { last = l; indexed = true; }
+        if (indexed && last + 1 < p.loops)
+            p.complete_at[last].push_back(t);
+    }
+    p.out_stride = strides_of(out);
+    p.out = result.data();
+
+    if (p.loops == 0)
+    {
+        double value = 1.0;
+        for (const double* in : p.in) value *= in[0];
+        result[0] = value;
+        return true;
+    }
+
+    t_row.resize(p.extent.back());
+    int64_t start[MAX_EVAL_INPUTS] = {};
+    switch (p.loops)
+    {
+        case 1: run_static<0, 1>(p, start, 0); break;
+        case 2: run_static<0, 2>(p, start, 0); break;
+        case 3: run_static<0, 3>(p, start, 0); break;
+        case 4: run_static<0, 4>(p, start, 0); break;
+        case 5: run_static<0, 5>(p, start, 0); break;
+        case 6: run_static<0, 6>(p, start, 0); break;
+        default: run_dynamic(p, 0, start, 0); break;
+    }
+    return true;
+}
+
+namespace {
+
+// Sparse operand: sorted, unique row-major positions over the extents of its (distinct) indices
+typedef struct SparseOperand {
+    string idxs;
+    vector<int64_t> extent;
+    vector<uint64_t> keys;
+    vector<double> values;
+} SparseOperand;
+
+typedef pair<uint64_t, double> KeyedValue;
+
+// Thrown when an operand's index space does not fit in a 64-bit key
+struct KeyOverflow {};
+
+vector<uint64_t> key_strides(const vector<int64_t>& extent)
+{
+    vector<uint64_t> stride(extent.size(), 1);
+    uint64_t volume = 1;
+    for (size_t d = extent.size(); d-- > 0;)
+    {
+        stride[d] = volume;
+        if (__builtin_mul_overflow(volume, static_cast<uint64_t>(extent[d]), &volume))
+            throw KeyOverflow();
+    }
+    return stride;
+}
+
+// Sort by key, sum equal keys and drop the zeros
+void sort_reduce(vector<KeyedValue>& entries)
+{
+    sort(entries.begin(), entries.end(), [](const KeyedValue& a, const KeyedValue& b) { return a.first < b.first; });
+    size_t out = 0;
+    for (size_t n = 0; n < entries.size();)
+    {
+        uint64_t key = entries[n].first;
+        double sum = 0.0;
+        for (; n < entries.size() && entries[n].first == key; n++)
+            sum += entries[n].second;
+        if (sum != 0.0)
+            entries[out++] = KeyedValue(key, sum);
+    }
+    entries.resize(out);
+}
+
+void assign_entries(SparseOperand& op, vector<KeyedValue>& entries)
+{
+    sort_reduce(entries);
+    op.keys.resize(entries.size());
+    op.values.resize(entries.size());
+    for (size_t n = 0; n < entries.size(); n++)
+    {
+        op.keys[n] = entries[n].first;
+        op.values[n] = entries[n].second;
+    }
+}
+
+// Stride of each of op's modes within the key over `target` indices (0 if the index is dropped)
+vector<uint64_t> target_strides(const SparseOperand& op, const string& target, const map<char, int64_t>& extent)
+{
+    vector<int64_t> target_extent;
+    for (char c : target)
+        target_extent.push_back(extent.at(c));
+    vector<uint64_t> stride = key_strides(target_extent);
+    vector<uint64_t> result(op.idxs.size(), 0);
+    for (size_t d = 0; d < op.idxs.size(); d++)
+    {
+        size_t pos = target.find(op.idxs[d]);
+        if (pos != string::npos)
+            result[d] = stride[pos];
+    }
+    return result;
+}
+
+// Key of entry `key` of op re-linearized with other strides
+inline uint64_t rekey(uint64_t key, const vector<uint64_t>& from, const vector<int64_t>& extent, const vector<uint64_t>& to)
+{
+    uint64_t result = 0;
+    for (size_t d = 0; d < from.size(); d++)
+        if (to[d] != 0)
+            result += ((key / from[d]) % static_cast<uint64_t>(extent[d])) * to[d];
+    return result;
+}
+
+SparseOperand load_sparse(const string& file, const tsTensor& tensor)
+{
+    SparseOperand op;
+    vector<size_t> mode_of;         // file mode -> operand mode
+    for (size_t d = 0; d < tensor.idxs.size(); d++)
+    {
+        size_t pos = op.idxs.find(tensor.idxs[d]);
+        if (pos == string::npos)
+        {
+            pos = op.idxs.size();
+            op.idxs.push_back(tensor.idxs[d]);
+            op.extent.push_back(tensor.shape[d]);
+        }
+        mode_of.push_back(pos);
+    }
+    vector<uint64_t> stride = key_strides(op.extent);
+
+    vector<KeyedValue> entries;
+    vector<int64_t> coord(op.idxs.size());
+    for_each_output_entry(file, [&](const int64_t* coords, size_t rank, double value) {
+        if (rank != tensor.shape.size())
+            throw runtime_error("Rank mismatch in " + file);
+        fill(coord.begin(), coord.end(), -1);
+        for (size_t d = 0; d < rank; d++)
+        {
+            if (coords[d] < 0 || coords[d] >= tensor.shape[d])
+                throw runtime_error("Coordinate out of range in " + file);
+            // A repeated index only keeps its diagonal
+            int64_t& c = coord[mode_of[d]];
+            if (c >= 0 && c != coords[d])
+                return true;
+            c = coords[d];
+        }
+        uint64_t key = 0;
+        for (size_t d = 0; d < coord.size(); d++)
+            key += coord[d] * stride[d];
+        entries.emplace_back(key, value);
+        return true;
+    });
+    assign_entries(op, entries);
+    return op;
+}
+
+// Sum out every index of op that is not in `kept`, and order the rest like `kept`
+SparseOperand project(const SparseOperand& op, const string& kept, const map<char, int64_t>& extent)
+{
+    SparseOperand result;
+    result.idxs = kept;
+    for (char c : kept)
+        result.extent.push_back(extent.at(c));
+    if (kept == op.idxs)
+    {
+        result.keys = op.keys;
+        result.values = op.values;
+        return result;
+    }
+
+    vector<uint64_t> from = key_strides(op.extent);
+    vector<uint64_t> to = target_strides(op, kept, extent);
+    vector<KeyedValue> entries(op.keys.size());
+    for (size_t n = 0; n < op.keys.size(); n++)
+        entries[n] = KeyedValue(rekey(op.keys[n], from, op.extent, to), op.values[n]);
+    assign_entries(result, entries);
+    return result;
+}
+
+typedef struct JoinEntry {
+    uint64_t join;      // position over the shared indices
+    uint64_t out;       // this operand's part of the result key
+    double value;
+} JoinEntry;
+
+// Entries of op sorted by their shared indices; indices in `placed` are left out of the result key
+vector<JoinEntry> join_entries(const SparseOperand& op, const string& shared, const string& kept, const string& placed, const map<char, int64_t>& extent)
+{
+    vector<uint64_t> from = key_strides(op.extent);
+    vector<uint64_t> to_join = target_strides(op, shared, extent);
+    vector<uint64_t> to_out = target_strides(op, kept, extent);
+    for (size_t d = 0; d < op.idxs.size(); d++)
+        if (placed.find(op.idxs[d]) != string::npos)
+            to_out[d] = 0;
+    vector<JoinEntry> entries(op.keys.size());
+    for (size_t n = 0; n < op.keys.size(); n++)
+        entries[n] = JoinEntry{rekey(op.keys[n], from, op.extent, to_join), rekey(op.keys[n], from, op.extent, to_out), op.values[n]};
+    sort(entries.begin(), entries.end(), [](const JoinEntry& x, const JoinEntry& y) { return x.join < y.join; });
+    return entries;
+}
+
+/**
+ * Contract a and b into the indices `kept`: sort both by their shared indices, then walk the
+ * matching groups in parallel and multiply every pair of entries. Indices of a and b that are not
+ * kept are summed. false if more than max_work products would be formed.
+ */
+bool contract(const SparseOperand& a, const SparseOperand& b, const string& kept, const map<char, int64_t>& extent,
+              const EinsumEvalLimits& limits, SparseOperand& result)
+{
+    string shared;
+    for (char c : a.idxs)
+        if (b.idxs.find(c) != string::npos)
+            shared.push_back(c);
+    // The result key of a product is the sum of both parts: b only adds the indices a lacks
+    vector<JoinEntry> ea = join_entries(a, shared, kept, "", extent);
+    vector<JoinEntry> eb = join_entries(b, shared, kept, a.idxs, extent);
+
+    // Matching groups (a begin, a end, b begin, b end) and the products they form
+    typedef struct Group { size_t a0, a1, b0, b1; } Group;
+    vector<Group> groups;
+    uint64_t work = 0;
+    for (size_t i = 0, j = 0; i < ea.size() && j < eb.size();)
+    {
+        if (ea[i].join < eb[j].join) { i++; continue; }
+        if (eb[j].join < ea[i].join) { j++; continue; }
+        Group g{i, i, j, j};
+        while (g.a1 < ea.size() && ea[g.a1].join == ea[i].join) g.a1++;
+        while (g.b1 < eb.size() && eb[g.b1].join == eb[j].join) g.b1++;
+        work += static_cast<uint64_t>(g.a1 - g.a0) * (g.b1 - g.b0);
+        if (work > limits.max_sparse_work)
+            return false;
+        groups.push_back(g);
+        i = g.a1;
+        j = g.b1;
+    }
+
+    // Split the groups into chunks of about equal work, one per thread
+    size_t threads = max<size_t>(1, min<size_t>(limits.threads, groups.size()));
+    vector<size_t> bounds{0};
+    uint64_t done = 0;
+    for (size_t n = 0; n < groups.size() && bounds.size() < threads; n++)
+    {
+        done += static_cast<uint64_t>(groups[n].a1 - groups[n].a0) * (groups[n].b1 - groups[n].b0);
+        if (done * threads >= work * bounds.size())
+            bounds.push_back(n + 1);
+    }
+    bounds.push_back(groups.size());
+
+    vector<vector<KeyedValue>> partial(bounds.size() - 1);
+    auto run_chunk = [&](size_t chunk) {
+        vector<KeyedValue>& out = partial[chunk];
+        size_t compacted = 0;
+        for (size_t n = bounds[chunk]; n < bounds[chunk + 1]; n++)
+        {
+            const Group& g = groups[n];
+            for (size_t i = g.a0; i < g.a1; i++)
+                for (size_t j = g.b0; j < g.b1; j++)
+                    out.emplace_back(ea[i].out + eb[j].out, ea[i].value * eb[j].value);
+            // Keep the buffer near the number of distinct keys when many products collide
+            if (out.size() > (1u << 20) && out.size() > 2 * compacted)
+            {
+                sort_reduce(out);
+                compacted = out.size();
+            }
+        }
+    };
+    vector<thread> workers;
+    for (size_t chunk = 1; chunk < partial.size(); chunk++)
+        workers.emplace_back(run_chunk, chunk);
+    if (!partial.empty())
+        run_chunk(0);
+    for (thread& t : workers)
+        t.join();
+
+    vector<KeyedValue> entries;
+    for (vector<KeyedValue>& p : partial)
+    {
+        entries.insert(entries.end(), p.begin(), p.end());
+        vector<KeyedValue>().swap(p);
+    }
+    result.idxs = kept;
+    result.extent.clear();
+    for (char c : kept)
+        result.extent.push_back(extent.at(c));
+    assign_entries(result, entries);
+    return true;
+}
+
+}
+
+bool evaluate_einsum_sparse(const tsKernel& kernel, tsTensorData& result, const EinsumEvalLimits& limits)
+{
+    if (!is_product_einsum(kernel))
+        return false;
+
+    map<char, int64_t> extent;
+    for (const tsTensor& t : kernel.tensors)
+    {
+        if (t.idxs.size() != t.shape.size())
+            return false;
+        for (size_t d = 0; d < t.idxs.size(); d++)
+        {
+            auto it = extent.emplace(t.idxs[d], t.shape[d]).first;
+            if (it->second != t.shape[d])
+                return false;
+        }
+    }
+    // Every output index must come from an input, and appear once
+    const tsTensor& out = kernel.tensors[0];
+    string out_idxs(out.idxs.begin(), out.idxs.end());
+    for (size_t d = 0; d < out_idxs.size(); d++)
+    {
+        if (out_idxs.find(out_idxs[d]) != d)
+            return false;
+        bool used = false;
+        for (size_t t = 1; t < kernel.tensors.size(); t++)
+            used |= find(kernel.tensors[t].idxs.begin(), kernel.tensors[t].idxs.end(), out_idxs[d]) != kernel.tensors[t].idxs.end();
+        if (!used)
+            return false;
+    }
+
+    try
+    {
+        vector<SparseOperand> ops;
+        for (size_t t = 1; t < kernel.tensors.size(); t++)
+        {
+            const tsTensor& tensor = kernel.tensors[t];
+            auto file = kernel.dataFileNames.find(string(1, tensor.name));
+            if (file == kernel.dataFileNames.end())
+                return false;
+            ops.push_back(load_sparse(file->second, tensor));
+        }
+
+        // Indices op `skip_a` and `skip_b` must keep: those of the output and of the other operands
+        auto needed = [&](const string& idxs, size_t skip_a, size_t skip_b) {
+            string kept;
+            for (char c : out_idxs)
+                if (idxs.find(c) != string::npos)
+                    kept.push_back(c);
+            for (char c : idxs)
+            {
+                if (kept.find(c) != string::npos) continue;
+                for (size_t k = 0; k < ops.size(); k++)
+                    if (k != skip_a && k != skip_b && ops[k].idxs.find(c) != string::npos)
+                    {
+                        kept.push_back(c);
+                        break;
+                    }
+            }
+            return kept;
+        };
+
+        // Sum out the indices only one operand uses
+        for (size_t k = 0; k < ops.size(); k++)
+            ops[k] = project(ops[k], needed(ops[k].idxs, k, k), extent);
+
+        // Greedy contraction order: the pair whose estimated result is smallest relative to the
+        // operands it replaces, preferring pairs that share indices over outer products
+        while (ops.size() > 1)
+        {
+            bool any_shared = false;
+            for (size_t i = 0; i < ops.size() && !any_shared; i++)
+                for (size_t j = i + 1; j < ops.size() && !any_shared; j++)
+                    any_shared = ops[i].idxs.find_first_of(ops[j].idxs) != string::npos;
+
+            size_t best_i = 0, best_j = 1;
+            pair<double, double> best_cost(0.0, 0.0);
+            bool have_best = false;
+            for (size_t i = 0; i < ops.size(); i++)
+                for (size_t j = i + 1; j < ops.size(); j++)
+                {
+                    double shared_volume = 1.0;
+                    bool shares = false;
+                    for (char c : ops[i].idxs)
+                        if (ops[j].idxs.find(c) != string::npos)
+                        {
+                            shared_volume *= extent.at(c);
+                            shares = true;
+                        }
+                    if (any_shared && !shares)
+                        continue;
+
+                    double kept_volume = 1.0;
+                    for (char c : needed(ops[i].idxs + ops[j].idxs, i, j))
+                        kept_volume *= extent.at(c);
+                    double nnz_i = ops[i].keys.size(), nnz_j = ops[j].keys.size();
+                    double products = nnz_i * nnz_j / max(shared_volume, 1.0);
+                    pair<double, double> cost(min(products, kept_volume) - nnz_i - nnz_j, products);
+                    if (!have_best || cost < best_cost)
+                    {
+                        best_i = i;
+                        best_j = j;
+                        best_cost = cost;
+                        have_best = true;
+                    }
+                }
+
+            string both = ops[best_i].idxs;
+            for (char c : ops[best_j].idxs)
+                if (both.find(c) == string::npos)
+                    both.push_back(c);
+            SparseOperand merged;
+            if (!contract(ops[best_i], ops[best_j], needed(both, best_i, best_j), extent, limits, merged))
+                return false;
+            ops.erase(ops.begin() + best_j);
+            ops[best_i] = move(merged);
+        }
+
+        SparseOperand final_op = project(ops[0], out_idxs, extent);
+        result = tsTensorData();
+        result.tensorName = out.name;
+        result.rank = out_idxs.size();
+        result.reserve(final_op.keys.size());
+        vector<uint64_t> stride = key_strides(final_op.extent);
+        vector<int> coord(result.rank);
+        for (size_t n = 0; n < final_op.keys.size(); n++)
+        {
+            for (size_t d = 0; d < result.rank; d++)
+                coord[d] = static_cast<int>((final_op.keys[n] / stride[d]) % static_cast<uint64_t>(final_op.extent[d]));
+            result.append(coord.data(), final_op.values[n]);
+        }
+    }
+    catch (const KeyOverflow&)
+    {
+        return false;
+    }
+    return true;
+}
+
+bool write_reference_result(const vector<int>& shape, const vector<double>& values, const string& file)
+{
+    tsTensorData data;
+    data.rank = shape.size();
+    vector<int> coord(shape.size(), 0);
+    for (size_t n = 0; n < values.size(); n++)
+    {
+        if (values[n] != 0.0)
+            data.append(coord.data(), values[n]);
+
+        // advance the row-major coordinate
+        for (size_t d = shape.size(); d-- > 0;)
+        {
+            if (++coord[d] < shape[d]) break;
+            coord[d] = 0;
+        }
+    }
+    return write_reference_result(shape, data, file);
+}
+
+bool write_reference_result(const vector<int>& shape, const tsTensorData& result, const string& file)
+{
+    // Backends write 1-based coordinates
+    tsTensorData data;
+    data.rank = result.rank;
+    data.reserve(result.data.size());
+    OutputFingerprint fingerprint(result.rank);
+    vector<int> written(result.rank);
+    vector<int64_t> written64(result.rank);
+    for (size_t n = 0; n < result.data.size(); n++)
+    {
+        if (result.data[n] == 0.0) continue;
+        const int* coord = result.coord(n);
+        for (size_t d = 0; d < result.rank; d++)
+        {
+            written[d] = coord[d] + 1;
+            written64[d] = written[d];
+        }
+        data.append(written.data(), result.data[n]);
+        fingerprint.add(written64.data(), result.data[n]);
+    }
+
+    if (!save_tensor_data(shape, data, file, "tns"))
+        return false;
+    fingerprint.save(fingerprint_file(file));
+    return true;
+}
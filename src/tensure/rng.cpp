@@ -0,0 +1,31 @@
+#include "tensure/rng.hpp"
+
+#include <atomic>
+
+// Job streams are iteration * STAGE_COUNT + stage; thread streams live above THREAD_STREAM_BASE
+static const uint64_t STAGE_COUNT = 16;
+static const uint64_t THREAD_STREAM_BASE = 1ull << 63;
+
+static atomic<uint64_t> g_campaign_seed{42};
+static atomic<uint64_t> g_next_thread_stream{0};
+
+void set_campaign_seed(uint64_t seed)
+{
+    g_campaign_seed = seed;
+}
+
+uint64_t campaign_seed()
+{
+    return g_campaign_seed;
+}
+
+tsRng job_rng(uint64_t iteration, RngStage stage)
+{
+    return tsRng(g_campaign_seed, iteration * STAGE_COUNT + static_cast<uint64_t>(stage));
+}
+
+tsRng& thread_rng()
+{
+    thread_local tsRng gen(g_campaign_seed, THREAD_STREAM_BASE + g_next_thread_stream++);
+    return gen;
+}
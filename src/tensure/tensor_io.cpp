@@ -0,0 +1,329 @@
+#include "tensure/tensor_io.hpp"
+#include "tensure/logger.hpp"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw runtime_error("Cannot open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw runtime_error("Cannot stat " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0)
+    {
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            close(fd);
+            throw runtime_error("Cannot mmap " + path);
+        }
+        // One sequential pass per parser thread
+        madvise(p, size_, MADV_SEQUENTIAL | MADV_WILLNEED);
+        data_ = static_cast<const char*>(p);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_)
+        munmap(const_cast<char*>(data_), size_);
+}
+
+MappedTensorFile::MappedTensorFile(const string& path) : file_(path)
+{
+    if (file_.size() < sizeof(TensorBinaryHeader))
+        throw runtime_error("Truncated tensor file: " + path);
+    header_ = reinterpret_cast<const TensorBinaryHeader*>(file_.data());
+    if (memcmp(header_->magic, TSB_MAGIC, sizeof(TSB_MAGIC)) != 0 || header_->version != TSB_VERSION)
+        throw runtime_error("Not a TenSure binary tensor file (or unsupported version): " + path);
+
+    uint64_t offset = sizeof(TensorBinaryHeader);
+    uint64_t expected = offset + tsb_align(header_->rank * sizeof(int64_t))
+                      + header_->rank * tsb_align(header_->nnz * sizeof(int32_t))
+                      + header_->nnz * sizeof(double);
+    if (file_.size() < expected)
+        throw runtime_error("Truncated tensor file: " + path);
+
+    shape_ = reinterpret_cast<const int64_t*>(file_.data() + offset);
+    offset += tsb_align(header_->rank * sizeof(int64_t));
+    for (uint32_t d = 0; d < header_->rank; d++)
+    {
+        coords_.push_back(reinterpret_cast<const int32_t*>(file_.data() + offset));
+        offset += tsb_align(header_->nnz * sizeof(int32_t));
+    }
+    values_ = reinterpret_cast<const double*>(file_.data() + offset);
+}
+
+// write(2) the whole range, retrying on short writes
+static bool write_all(int fd, const void* data, size_t bytes)
+{
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0)
+    {
+        ssize_t n = ::write(fd, p, bytes);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool write_padding(int fd, uint64_t bytes)
+{
+    static const char zeros[TSB_ALIGNMENT] = {};
+    return write_all(fd, zeros, tsb_align(bytes) - bytes);
+}
+
+bool save_tensor_binary(const vector<int>& shape, const tsTensorData& data, const string& filename, uint32_t index_base)
+{
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        cerr << "Error: could not open file " << filename << endl;
+        LOG_WARN("Error: could not open file " + filename);
+        return false;
+    }
+
+    TensorBinaryHeader header{};
+    memcpy(header.magic, TSB_MAGIC, sizeof(TSB_MAGIC));
+    header.version = TSB_VERSION;
+    header.rank = static_cast<uint32_t>(data.rank);
+    header.nnz = data.size();
+    header.index_base = index_base;
+
+    vector<int64_t> shape64(shape.begin(), shape.end());
+    shape64.resize(data.rank, 0);
+    bool ok = write_all(fd, &header, sizeof(header))
+           && write_all(fd, shape64.data(), shape64.size() * sizeof(int64_t))
+           && write_padding(fd, shape64.size() * sizeof(int64_t));
+
+    // Transpose the row-major coordinates into one array per mode, a buffer at a time
+    thread_local vector<int32_t> column;
+    const size_t column_chunk = TensorTextWriter::BUFFER_SIZE / sizeof(int32_t);
+    for (size_t d = 0; d < data.rank && ok; d++)
+    {
+        for (size_t begin = 0; begin < data.size() && ok; begin += column_chunk)
+        {
+            size_t end = min(data.size(), begin + column_chunk);
+            column.resize(end - begin);
+            for (size_t n = begin; n < end; n++)
+                column[n - begin] = data.coordinate[n * data.rank + d];
+            ok = write_all(fd, column.data(), column.size() * sizeof(int32_t));
+        }
+        ok = ok && write_padding(fd, data.size() * sizeof(int32_t));
+    }
+    ok = ok && write_all(fd, data.data.data(), data.size() * sizeof(double));
+
+    if (::close(fd) != 0)
+        ok = false;
+    return ok;
+}
+
+TensorTextWriter::TensorTextWriter() : buffer_(BUFFER_SIZE) {}
+
+TensorTextWriter::~TensorTextWriter()
+{
+    close();
+}
+
+bool TensorTextWriter::open(const string& filename)
+{
+    close();
+    fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    failed_ = (fd_ < 0);
+    used_ = 0;
+    bytes_written_ = 0;
+    return !failed_;
+}
+
+bool TensorTextWriter::close()
+{
+    if (fd_ < 0)
+        return !failed_;
+    flush();
+    if (::close(fd_) != 0)
+        failed_ = true;
+    fd_ = -1;
+    return !failed_;
+}
+
+void TensorTextWriter::flush()
+{
+    size_t off = 0;
+    while (off < used_ && !failed_)
+    {
+        ssize_t n = ::write(fd_, buffer_.data() + off, used_ - off);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            failed_ = true;
+            break;
+        }
+        off += static_cast<size_t>(n);
+    }
+    bytes_written_ += off;
+    used_ = 0;
+}
+
+void TensorTextWriter::put(int value)
+{
+    reserve(16);
+    used_ = to_chars(buffer_.data() + used_, buffer_.data() + BUFFER_SIZE, value).ptr - buffer_.data();
+}
+
+void TensorTextWriter::put(uint64_t value)
+{
+    reserve(24);
+    used_ = to_chars(buffer_.data() + used_, buffer_.data() + BUFFER_SIZE, value).ptr - buffer_.data();
+}
+
+void TensorTextWriter::put(double value)
+{
+    reserve(32);
+    used_ = to_chars(buffer_.data() + used_, buffer_.data() + BUFFER_SIZE, value).ptr - buffer_.data();
+}
+
+void TensorTextWriter::put(char c)
+{
+    reserve(1);
+    buffer_[used_++] = c;
+}
+
+void TensorTextWriter::put(const string& s)
+{
+    for (char c : s)
+        put(c);
+}
+
+bool save_tensor_data(const vector<int>& shape, const tsTensorData& data, const string& filename, const string& tfmt)
+{
+    if (tfmt == "tsb")
+        return save_tensor_binary(shape, data, filename);
+    if (tfmt != "tns" && tfmt != "ttx")
+    {
+        LOG_WARN("Unsupported tensor file format: " + tfmt);
+        return false;
+    }
+
+    thread_local TensorTextWriter out;
+    if (!out.open(filename))
+    {
+        cerr << "Error: could not open file " << filename << endl;
+        LOG_WARN("Error: could not open file " + filename);
+        return false;
+    }
+
+    if (tfmt == "ttx")
+    {
+        // header, then the shape of the tensor and its nnz
+        out.put(string("%%MatrixMarket tensor coordinate real general\n"));
+        for (int dim : shape)
+        {
+            out.put(dim);
+            out.put(' ');
+        }
+        out.put(static_cast<uint64_t>(data.size()));
+        out.put('\n');
+    }
+
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        const int* coord = data.coord(i);
+        for (size_t j = 0; j < data.rank; j++)
+        {
+            out.put(coord[j]);
+            out.put(' ');
+        }
+        out.put(data.data[i]);
+        out.put('\n');
+    }
+    return out.close();
+}
+
+BackgroundTensorWriter::BackgroundTensorWriter(size_t num_threads)
+{
+    for (size_t t = 0; t < num_threads; t++)
+        workers_.emplace_back(&BackgroundTensorWriter::worker_loop, this);
+}
+
+BackgroundTensorWriter::~BackgroundTensorWriter()
+{
+    {
+        lock_guard<mutex> lock(mtx_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    // Workers drain the queue before exiting, so every submitted file is written
+    for (auto& w : workers_)
+        w.join();
+}
+
+future<bool> BackgroundTensorWriter::submit(const vector<int>& shape, shared_ptr<const tsTensorData> data, const string& filename, const string& tfmt)
+{
+    WriteJob job{shape, std::move(data), filename, tfmt, promise<bool>()};
+    future<bool> result = job.done.get_future();
+    if (workers_.empty())
+    {
+        job.done.set_value(save_tensor_data(job.shape, *job.data, job.filename, job.tfmt));
+        return result;
+    }
+
+    {
+        lock_guard<mutex> lock(mtx_);
+        queue_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+    return result;
+}
+
+void BackgroundTensorWriter::worker_loop()
+{
+    while (true)
+    {
+        WriteJob job;
+        {
+            unique_lock<mutex> lock(mtx_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty())
+                return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        job.done.set_value(save_tensor_data(job.shape, *job.data, job.filename, job.tfmt));
+    }
+}
+
+static mutex g_writer_mutex;
+static unique_ptr<BackgroundTensorWriter> g_writer;
+
+BackgroundTensorWriter& tensor_writer()
+{
+    lock_guard<mutex> lock(g_writer_mutex);
+    if (!g_writer)
+        g_writer = make_unique<BackgroundTensorWriter>(1);
+    return *g_writer;
+}
+
+void configure_tensor_writer(size_t num_threads)
+{
+    lock_guard<mutex> lock(g_writer_mutex);
+    g_writer = make_unique<BackgroundTensorWriter>(num_threads);
+}
@@ -1,4 +1,6 @@
 #include "tensure/utils.hpp"
+#include "tensure/tensor_io.hpp"
+#include "tensure/comparator.hpp"
 
 ostream& operator<<(ostream& os, const tsTensor& tensor) 
 {
@@ -194,7 +196,7 @@ void loadKernelJson(const string& filename, map<char, tsTensor>& tensorsMap, vec
     computations.clear();
     for (auto& c : j["computations"])
     {
-        computations.push_back({c["expression"]});
+        computations.push_back(tsComputation::from_json(c));
     }
 }
 
@@ -211,7 +213,7 @@ void ensure_directory_exists(const std::string& path)
     }
 }
 
-bool generate_ref_kernel(const vector<tsTensor>& tensors, const vector<string>& computations, const vector<string>& dataFileNames, string file_name)
+bool generate_ref_kernel(const vector<tsTensor>& tensors, const vector<string>& computations, const vector<string>& dataFileNames, string file_name, tsKernel* kernel_out)
 {
     if (tensors.size()-1 != dataFileNames.size()) return false;
     // cout << "SDSDS 1" << endl;
@@ -252,7 +254,9 @@ bool generate_ref_kernel(const vector<tsTensor>& tensors, const vector<string>&
         filesystem::remove(tmp_name, ec);
         return false;
     }
-    
+
+    if (kernel_out)
+        *kernel_out = std::move(kernel);
     return true;
 }
 
@@ -283,215 +287,11 @@ vector<vector<string>> generate_all_formats(int rank)
     return all;
 }
 
-struct VecHash {
-    size_t operator()(const std::vector<int>& v) const noexcept {
-        size_t h = 0;
-        for (int x : v) {
-            h = h * 1315423911u + std::hash<int>()(x);
-        }
-        return h;
-    }
-};
-
-static bool ends_with(const std::string& s, const std::string& suffix) {
-    return s.size() >= suffix.size() &&
-           s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
-}
-
 bool compare_outputs(const string& ref_output, const string& kernel_output, double tol)
 {
-    auto read_tns = [&](const string& path) {
-        unordered_map<vector<int>, double, VecHash> data;
-
-        ifstream file(path);
-        if (!file.is_open()) {
-            throw runtime_error("Cannot open " + path);
-        }
-
-        string line;
-        while (getline(file, line)) {
-            if (line.empty()) continue;
-
-            istringstream iss(line);
-            vector<string> toks;
-            string tok;
-
-            while (iss >> tok) {
-                toks.push_back(tok);
-            }
-
-            if (toks.size() < 2)
-                continue; // ignore garbage lines
-
-            double val = std::stod(toks.back());
-            if (val == 0.0)
-                continue; // skip zeros entirely
-
-            vector<int> coords;
-            coords.reserve(toks.size() - 1);
-            for (size_t i = 0; i + 1 < toks.size(); ++i) {
-                coords.push_back(std::stoi(toks[i]));
-            }
-
-            data.emplace(move(coords), val);
-        }
-        return data;
-    };
-
-    auto read_mtx = [&](const string& path) {
-        unordered_map<vector<int>, double, VecHash> data;
-
-        ifstream file(path);
-        if (!file.is_open()) {
-            throw runtime_error("Cannot open " + path);
-        }
-
-        string line;
-        // Skip comments and header lines
-        while(getline(file, line)) {
-            if (line.empty()) continue;
-            if (line[0] == '%') continue;
-            break;
-        }
-
-        // First non-comment line: M N NNZ
-        {
-            istringstream iss(line);
-            vector<string> toks;
-            string tok;
-
-            while (iss >> tok) toks.push_back(tok);
-            if (toks.size() < 3)
-                throw runtime_error("Invalid MTX header: " + path);
-        }
-
-        // Read triplets
-        while (getline(file, line)) {
-            if (line.empty()) continue;
-
-            istringstream iss(line);
-            vector<string> toks;
-            string tok;
-            while (iss >> tok) toks.push_back(tok);
-
-            if (toks.size() < 3)
-                continue;
-
-            int i = std::stoi(toks[0]);
-            int j = std::stoi(toks[1]);
-            double val = std::stod(toks[2]);
-
-            if (val == 0.0)
-                continue;
-            
-            vector<int> coords = {i, j};
-            data.emplace(move(coords), val);
-        }
-
-        return data;
-    };
-
-    auto read_ttx = [&](const string& path) {
-        unordered_map<vector<int>, double, VecHash> data;
-
-        ifstream file(path);
-        if (!file.is_open()) {
-            throw runtime_error("Cannot open " + path);
-        }
-
-        string line;
-        bool read_dims = false;
-
-        while (getline(file, line)) {
-            if (line.empty()) continue;
-
-            // Skip comments
-            if (line[0] == '%') continue;
-
-            // First non-comment line = dimension line → skip it
-            if (!read_dims) {
-                read_dims = true;
-                continue;
-            }
-
-            // Now everything else should be data
-            istringstream iss(line);
-            vector<string> toks;
-            string tok;
-
-            while (iss >> tok)
-                toks.push_back(tok);
-
-            // Need at least 1 coord + value
-            if (toks.size() < 2)
-                continue;  // ignore malformed line
-
-            // Parse value
-            double val = 0.0;
-            try {
-                val = std::stod(toks.back());
-            } catch (...) {
-                continue; // skip garbage line
-            }
-
-            // Skip zero entries
-            if (val == 0.0)
-                continue;
-
-            // Parse coordinates
-            vector<int> coords;
-            coords.reserve(toks.size() - 1);
-
-            bool bad_coord = false;
-            for (size_t i = 0; i + 1 < toks.size(); ++i) {
-                try {
-                    coords.push_back(std::stoi(toks[i]));
-                } catch (...) {
-                    bad_coord = true;
-                    break;
-                }
-            }
-
-            if (bad_coord)
-                continue;
-
-            data.emplace(std::move(coords), val);
-        }
-
-        return data;
-    };
-
-    auto read_tensor = [&](const string& path) {
-        if (ends_with(path, ".tns")) 
-            return read_tns(path);
-        if (ends_with(path, ".mtx")) 
-            return read_mtx(path);
-        if (ends_with(path, ".ttx")) 
-            return read_ttx(path);
-        
-        throw runtime_error("Unsupported tensor format: " + path);
-    };
-
-    auto ref = read_tensor(ref_output);
-    auto out = read_tensor(kernel_output);
-
-    if (ref.size() != out.size())
-        return false;
-
-    for (auto& [coords, val_ref] : ref) {
-        auto it = out.find(coords);
-        if (it == out.end())
-            return false;
-
-        if (fabs(it->second - val_ref) > tol)
-            return false;
-    }
-
-    return true;
+    return ReferenceOutput(ref_output).matches(kernel_output, tol);
 }
 
-
-
 // Helper struct to hold parsed tensor data
 struct TensorInfo {
     string name;